@@ -15,21 +15,145 @@ ____________
 	The disk color for human is a choice of the user
 	The user can choose the value of 'level' which is equivalent to the number of levels the alpha-beta method should proceed in order to apply its evaluation function at the states of the last level.
 
+BUILD:
+______
+	gcc -pthread -o reversi reversi.c -lm
+
 PROCESS FLOW:
 _____________
 
 	The program sequentially asks for following initial information before proceeding with the game:
-		a. newgame black|white <size> <level>
+		a. newgame black|white <size> <level> [option=value ...]
+		   The size must be even, from 4 to 64. Options:
+			hash=<MB>		transposition table size in megabytes (default 16, 0 disables it)
+			time=<ms>		time limit per computer move; the level becomes the deepest level searched
+			clock=<ms>		total time for all computer moves, spread over the remaining moves
+			order=on|off	move ordering: hash move, corners, killers and history (default on)
+			mobilitysort=<n>	also sort by opponent replies at nodes with at least n levels left (default 5, 0 disables)
+			threads=<n>		search threads sharing the transposition table (default 1)
+			simd=on|off		SSE2 and AVX2 move generation on boards other than 8x8 up to 16x16, when the processor has them;
+					off uses the plain 64-bit kernels (default on)
+			leafbatch=on|off	on 8x8 with eval=disks or mobility, evaluate the children at the search horizon four at a time,
+					in AVX2 lanes when simd allows, instead of playing each; the search and its counts are unchanged (default on)
+			ponder=on|off	while waiting for the user's move, search the user's replies in a background thread; a reply searched
+					to the full level is answered at once, the others find the work in the hash table (default off)
+			search=alphabeta|pvs|mtdf	plain alpha-beta, principal variation search with aspiration windows, or MTD(f)
+					null-window passes over the transposition table (default alphabeta)
+			eval=disks|patterns|mobility	score the search horizon by the disk count, by edge, corner and diagonal patterns, or by
+					the disk count plus weighted differences in moves and in corners (default disks)
+			endgame=<n>		solve positions with n or fewer empty cells to the end of the game (default 0, off)
+			solve=exact|wld	the endgame solver finds the exact disc margin, or only win, loss or draw (default exact)
+			book=<path>		play moves from an opening book built by the book command below, searching only outside it
+			probcut=<path>	cut nodes by Multi-ProbCut, with shallow searches and the fits written by the probcut command below
+			probcutconfidence=<t>	cut only when the deep value is t fit deviations outside the window (default 1.5)
+			stats=<path>	append a JSON line of search statistics after every computer move, and one with the totals at game end
+			record=<path>	write the game's moves to a binary record: "RVGR", version 1 and size bytes, then each move as
+					square + 1 (row * size + column, 0 for a pass) in one byte, or as a varint on boards of 16x16 and up
+		   Instead of newgame, 'selfplay <size> <games> [option=value ...]' plays engine A against engine B and prints
+		   A's wins, draws and losses, the average disc margin, games/sec and nodes/sec. Engine A plays black in even
+		   games and white in odd ones. The newgame options above set both engines, or one engine with an a. or b. prefix
+		   (b.time=100). Other options:
+			level=<n>		search level of both engines (a.level=<n>, b.level=<n> for one)
+			workers=<n>		games played at the same time (default 1)
+			random=<n>		random moves that open every pair of games (default 0)
+			seed=<n>		seed of the random openings
+		   'perft <size> <depth> [option=value ...]' counts the positions reachable in 1 to depth moves, passes included,
+		   and prints leaves/sec for each depth. Options:
+			bulk=on|off		count the last move from the move list instead of playing it (default off)
+			verify=on|off	check the search's move generator, bitboards up to 16x16 and the frontier past that, against a scan of
+					the whole board at every node (default off)
+			position=<cells>	start from size*size cells of B, W or -, row by row, instead of the initial position
+			tomove=black|white	side to move in that position (default black)
+		   'book <size> <plies> <path> level=<n> [option=value ...]' builds an opening book: the engine searches, with the
+		   newgame options given, every position of the first plies moves that a game against it can reach, for either
+		   color, and writes its moves to path. The file is mapped into memory when a game opens it.
+		   'probcut <size> <positions> <path> [option=value ...]' calibrates Multi-ProbCut: it searches positions of games
+		   the engine plays against itself to every depth, and writes to path, per game stage, how the deep values follow
+		   the shallow ones. The newgame options given, eval in particular, must match the games that load it. Options:
+			maxdepth=<n>	deepest depth fitted (default 8, at most 16)
+			level=<n>		search level of the moves that lead to the positions (default 2)
+			random=<n>		random moves that open every game, at most size*size - 5 (default 8)
+			seed=<n>		seed of the random moves
+		   'batch <size> <level> [option=value ...]' searches a stream of positions with the newgame options and writes
+		   '<index> <move> <score> <depth> <nodes>' for each, in input order. The score is the search value for the side
+		   to move; the move is 'pass' when that side has none, and 'end' with the disc margin when neither side has one.
+		   Unreadable positions give '<index> invalid'. Memory stays the same however long the input is. Options:
+			input=<path>	positions to read, - for the rest of stdin (default)
+			output=<path>	file for the results, - for stdout (default)
+			format=text|binary	text lines '<cells> black|white', cells as for perft, or binary records of one byte for the
+					side to move (0 black, 1 white) and the cells row by row at 2 bits each (0 empty, 1 black, 2 white),
+					four to a byte from the low bits up (default text)
+			workers=<n>		threads searching positions, each with its own engines (default 1)
+			queue=<n>		positions read ahead of the oldest unwritten result (default 4 per worker)
+		   'replay <path> [positions=<path>]' plays a game record through, checking every move, and prints the moves and
+		   the final position as text and in the batch binary encoding. positions=<path> also writes every position of
+		   the game, the last included, to path in that encoding, ready for 'batch ... format=binary'.
+		   'protocol <size> <level> [option=value ...]' drives the engine from another program: one command per line, one
+		   line per answer, and nothing else printed. Moves are the column letters and the row number, such as d3 or j10,
+		   with aa, ab and so on past column z. The newgame options apply; the level is the deepest search, and time=
+		   the time of a go that gives none (unlimited without it). Commands:
+			position startpos|<cells> black|white [moves <move>|pass ...]	set the position, cells as for perft; 'ok' or 'error position'
+			move <move>|pass	play a move for the side to move; 'ok' or 'error illegal move'
+			go [depth=<n>] [time=<ms>]	search in the background and answer 'bestmove <move> score <s> depth <d> nodes <n>
+					time <ms>', the move being pass or, when the game is over, none with the disc margin as the score
+			stop		end the search with the move of its deepest finished level
+			stats		counters of the last answered search
+			show		'position <cells> black|white'
+			isready		'readyok'
+			quit
+		   'leafbench <positions> [option=value ...]' times the evaluation of every child of 8x8 positions from random games,
+		   one by one as the search does without leafbatch and in batches by each kernel the processor runs, prints
+		   ns/leaf for each and checks that they agree. The eval and simd options apply. Options:
+			rounds=<n>		passes timed over the positions (default 100)
+			seed=<n>		seed of the random games
 		b. 'play <move>' command like playb3. This is the position human player wishes to play.
 		c. 'cont' command for the computer player to play its move. The current state is printed afterwards, indicating by a * all legal moves for the human player.
 		d. 'showstate' command prints the state of current board  indicating by a * all legal moves for the human player, if it is his/her turn to play.
-		e. 'quit' command is to quit the game
+		e. 'showstats' command prints the nodes, depth, time, leaf evaluations, branching factor, cutoffs by move index, hash table use and per-depth progress of the last computer search.
+		f. 'quit' command is to quit the game
 
 *********************************************************************************************************************/
 /*Include header files needed for the implementation*/
 #include "stdio.h"
+#include "stdlib.h"
 #include "stdbool.h"
+#include "stdint.h"
 #include "string.h"
+#include "ctype.h"
+#include "time.h"
+#include "math.h"
+
+/*SSE2 and AVX2 kernels for the wide bitboards and the 8x8 leaf batches, picked at run time; define REVERSI_NO_SIMD to
+  build without them*/
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) && !defined(REVERSI_NO_SIMD)
+#define WIDE_BITBOARD_SIMD 1
+#include <immintrin.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#include <io.h>
+#include <fcntl.h>
+typedef HANDLE Thread_Handle;
+typedef CRITICAL_SECTION Mutex_Handle;
+typedef CONDITION_VARIABLE Condition_Handle;
+typedef unsigned (__stdcall *Thread_Routine)(void*);
+#define THREAD_FUNCTION unsigned __stdcall
+#define THREAD_RETURN return 0
+#else
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+typedef pthread_t Thread_Handle;
+typedef pthread_mutex_t Mutex_Handle;
+typedef pthread_cond_t Condition_Handle;
+typedef void* (*Thread_Routine)(void*);
+#define THREAD_FUNCTION void*
+#define THREAD_RETURN return NULL
+#endif
 
 #pragma warning(disable : 4996)
 
@@ -38,9 +162,6 @@ _____________
 /******************/
 
 #define ZERO 0																/*Macro for magic number '0'*/
-#define MOVE_NOT_ALLOWED 0													/*Macro for move not allowed*/
-#define MOVE_ALLOWED 1														/*Macro for move allowed*/
-#define INITIAL_LEVEL 1														/*Macro for initial level*/
 #define COMPUTER_TURN 1														/*Macro for computer turn*/
 #define COMPUTER_PLAYER 1
 #define USER_TURN 2
@@ -48,8 +169,105 @@ _____________
 #define INITIAL_BLACK_DISKS 2
 #define INITIAL_WHITE_DISKS 2
 #define INVALID_VALUE 0xFFFFFF
-#define VERY_NEGATIVE_VALUE -999
-#define VERY_POSITIVE_VALUE  999
+#define VERY_NEGATIVE_VALUE -99999999
+#define VERY_POSITIVE_VALUE  99999999
+#define BITBOARD_SIZE 8
+#define BITBOARD_DIRECTIONS 8
+#define BITBOARD_NOT_A_FILE 0xFEFEFEFEFEFEFEFEULL
+#define BITBOARD_NOT_H_FILE 0x7F7F7F7F7F7F7F7FULL
+#define BITBOARD_CORNERS 0x8100000000000081ULL
+#define MIN_BOARD_SIZE 4
+#define MAX_BOARD_SIZE 64
+#define MENU_INPUT_LENGTH 256
+#define BLACK_INDEX 0
+#define WHITE_INDEX 1
+#define ZOBRIST_SEED 0x5245564552534921ULL
+#define DEFAULT_HASH_MEGABYTES 16
+#define TT_BOUND_NONE 0
+#define TT_BOUND_EXACT 1
+#define TT_BOUND_LOWER 2
+#define TT_BOUND_UPPER 3
+#define TT_BOUND_MASK 3												/*the bound byte keeps the table generation above these bits*/
+#define TT_GENERATION_SHIFT 2
+#define TT_GENERATIONS 64
+#define NO_TIME_LIMIT -1
+#define TIME_CHECK_INTERVAL 1024										/*nodes searched between two clock reads*/
+#define KILLERS_PER_LEVEL 2
+#define ORDER_HASH_MOVE_SCORE 0x70000000
+#define ORDER_CORNER_SCORE 0x60000000
+#define ORDER_KILLER_SCORE 0x50000000
+#define ORDER_MOBILITY_SHIFT 16											/*mobility ranks above any history score*/
+#define ORDER_HISTORY_LIMIT 0xFFFF
+#define DEFAULT_MOBILITY_SORT_DEPTH 5
+#define MAIN_SEARCH_THREAD 0
+#define MAX_SEARCH_THREADS 256
+#define ENDGAME_EXACT 0
+#define ENDGAME_WIN_LOSS_DRAW 1
+#define ENDGAME_LAST_EMPTIES 4											/*solved on the bitboard without move lists*/
+#define ENDGAME_FASTEST_FIRST_EMPTIES 6								/*above this, endgame moves are sorted by opponent replies*/
+#define CUTOFF_INDEX_SLOTS 8											/*cutoffs by move index; the last slot counts all later moves*/
+#define SEARCH_ALPHA_BETA 0
+#define SEARCH_PRINCIPAL_VARIATION 1
+#define SEARCH_MTDF 2
+#define ASPIRATION_DISK_WINDOW 16										/*half width around the last score, in disks*/
+#define ASPIRATION_PATTERN_WINDOW 100
+#define ASPIRATION_MOBILITY_WINDOW 40
+#define EVALUATION_DISKS 0
+#define EVALUATION_PATTERNS 1
+#define EVALUATION_MOBILITY 2
+#define MOBILITY_MOVE_WEIGHT 4
+#define MOBILITY_CORNER_WEIGHT 16
+#define MOBILITY_FINAL_DISK_WEIGHT 400									/*a finished game outweighs the move and corner terms*/
+#define PATTERN_KIND_COUNT 3
+#define PATTERN_EDGE 0
+#define PATTERN_CORNER_BLOCK 1
+#define PATTERN_DIAGONAL 2
+#define PATTERN_MAX_COUNT 16											/*four of each kind, one set per corner*/
+#define PATTERN_EDGE_LENGTH 8
+#define PATTERN_BLOCK_SIZE 3
+#define PATTERN_MAX_LENGTH 9
+#define PATTERN_EMPTY_DIGIT 0
+#define PATTERN_BLACK_DIGIT 1
+#define PATTERN_WHITE_DIGIT 2
+#define PATTERN_CORNER_WEIGHT 30										/*counted once by each of the corner's two edges*/
+#define PATTERN_C_SQUARE_PENALTY 15
+#define PATTERN_X_SQUARE_PENALTY 25
+#define PATTERN_EDGE_WEIGHT 4
+#define PATTERN_STABLE_WEIGHT 10
+#define PATTERN_INNER_WEIGHT 2
+#define PATTERN_FINAL_DISK_WEIGHT 2000								/*a finished game outweighs any pattern value*/
+#define BOOK_MAGIC "RVBK"
+#define BOOK_VERSION 1													/*books of another version are refused*/
+#define MPC_STAGES 4														/*ProbCut fits per game stage, by the share of filled cells*/
+#define MPC_MIN_DEPTH 3
+#define MPC_MAX_DEPTH 16
+#define MPC_CHECKS_PER_DEPTH 2
+#define MPC_MIN_SLOPE 0.05												/*flatter fits say nothing about the deep value*/
+#define MPC_MIN_SAMPLES 8
+#define DEFAULT_PROBCUT_CONFIDENCE 1.5									/*cut margin, in deviations of the fit*/
+#define MPC_DEFAULT_CALIBRATION_DEPTH 8
+#define MPC_CALIBRATION_RANDOM_PLIES 8
+#define MPC_CALIBRATION_GAME_LEVEL 2
+#define POSITION_CODE_EMPTY 0
+#define POSITION_CODE_BLACK 1
+#define POSITION_CODE_WHITE 2
+#define RECORD_MAGIC "RVGR"
+#define RECORD_VERSION 1
+#define RECORD_PASS_CODE 0
+#define BATCH_SLOT_EMPTY 0
+#define BATCH_SLOT_QUEUED 1
+#define BATCH_SLOT_SEARCHING 2
+#define BATCH_SLOT_DONE 3
+#define BATCH_SLOTS_PER_WORKER 4
+#define BATCH_RESULT_LENGTH 96
+#define PROTOCOL_RESPONSE_LENGTH 256
+#define PROTOCOL_MOVE_LENGTH 16											/*"bl64" at most, but room for any int row*/
+#define PROTOCOL_UNLIMITED_TIME 0x3FFFFFFF								/*a go with no time set still deepens one level at a time, so stop can end it*/
+#define FRONTIER_SQUARE_WAS_SET (1 << 8)									/*in Move_Undo frontier_changes, above the eight direction bits*/
+#define WIDE_BITBOARD_WORDS 4
+#define WIDE_BITBOARD_MAX_SIZE 16											/*16x16 fills the four words*/
+#define LEAF_BATCH_WIDTH 4												/*horizon children evaluated together, one per AVX2 lane*/
+#define LEAF_BENCHMARK_ROUNDS 100
 
 //Alpha_Beta_Return max_value(Board_Cell** current_board, int alpha_value, int beta_value, int search_level);
 //Alpha_Beta_Return min_value(Board_Cell** current_board, int alpha_value, int beta_value, int search_level);
@@ -82,53 +300,316 @@ typedef struct
 	Cell_Coordinates cell_coordinates;
 }Board_Cell;
 
+/*8x8 position as two disk masks, bit (row_index * 8 + column_index) set for an occupied cell*/
+typedef struct
+{
+	uint64_t player_disks;
+	uint64_t opponent_disks;
+}Bitboard_Position;
 
-int board_size									= INVALID_VALUE;
-int game_level									= INVALID_VALUE;							
-int current_turn								= INVALID_VALUE;
-int current_black_disks							= INITIAL_BLACK_DISKS;
-int current_white_disks							= INITIAL_WHITE_DISKS;
-int current_level								= INITIAL_LEVEL;
-char user_disk_color[6];
-char computer_disk_color[6];
-char* current_input_command						= NULL;
-Board_Cell** board;								/*NxN grid*/
+/*A bit set of the squares of a board other than 8x8, up to 16x16: square row_index * board_size + column_index is
+  bit square % 64 of word square / 64. Words past the board are kept empty*/
+typedef struct
+{
+	uint64_t words[WIDE_BITBOARD_WORDS];
+}Wide_Bitboard;
 
-int global_alpha_value, global_beta_value;
+typedef struct
+{
+	Wide_Bitboard player_disks;
+	Wide_Bitboard opponent_disks;
+}Wide_Bitboard_Position;
 
-void reset_parameters()
+/*Shifts and edge masks of one board size, in the direction order of the 8x8 tables*/
+typedef struct
 {
-	game_level = INVALID_VALUE;
-	current_turn = INVALID_VALUE;
-	current_black_disks = INITIAL_BLACK_DISKS;
-	current_white_disks = INITIAL_WHITE_DISKS;
+	int word_count;
+	int shift_amounts[BITBOARD_DIRECTIONS];
+	Wide_Bitboard shift_masks[BITBOARD_DIRECTIONS];	/*squares a shift may land on: the board, less the column it wraps into*/
+	Wide_Bitboard board_mask;
+}Wide_Bitboard_Geometry;
 
-	free(current_input_command);
+/*Move generation specialised on the word count and the instruction set*/
+typedef struct
+{
+	const char* name;
+	void (*get_moves)(const Wide_Bitboard_Geometry* geometry, const Wide_Bitboard* player_disks, const Wide_Bitboard* opponent_disks, Wide_Bitboard* moves);
+	void (*get_flips)(const Wide_Bitboard_Geometry* geometry, const Wide_Bitboard* player_disks, const Wide_Bitboard* opponent_disks, int square_index, Wide_Bitboard* flips);
+}Wide_Bitboard_Kernels;
 
-	for (int i = 0; i < board_size; i++)
-	{
-		if (board[i] != NULL)
-		{
-			free(board[i]);
-		}
-	}
-	if (board != NULL)
-	{
-		free(board);
-	}
-	board_size = INVALID_VALUE;
+/*Values of up to LEAF_BATCH_WIDTH children of an 8x8 position, each after one of squares is played, from the
+  point of view of the side that plays them*/
+typedef struct
+{
+	const char* name;
+	void (*evaluate_children)(uint64_t player_disks, uint64_t opponent_disks, const int* squares, int count, bool with_mobility, int* values);
+}Leaf_Batch_Kernel;
 
-}
+typedef struct
+{
+	int* moves;									/*packed square indices, row_index * board_size + column_index*/
+	int count;
+}Move_List;
+
+/*Move lists of all search levels are carved from one buffer, last in first out*/
+typedef struct
+{
+	int* moves;
+	int capacity;
+	int top;
+}Move_Arena;
+
+typedef struct
+{
+	int* flip_stack;							/*flipped squares of every move on the current search line*/
+	int flip_stack_top;
+	Move_Arena move_arena;
+	int* killer_moves;							/*KILLERS_PER_LEVEL squares per search level*/
+	int* history_scores[2];						/*per square, for the computer and for the user*/
+	uint64_t* frontier;							/*generic board: a bit per empty square next to a disk, row by row*/
+}Search_Workspace;
+
+/*Counters of one search, summed over its threads, or of all searches of a game*/
+typedef struct
+{
+	unsigned long long nodes;
+	unsigned long long leaf_evaluations;
+	unsigned long long interior_nodes;			/*nodes whose moves were searched*/
+	unsigned long long moves_searched;
+	unsigned long long cutoffs[CUTOFF_INDEX_SLOTS];	/*by index of the move in the ordered list*/
+	unsigned long long hash_probes;
+	unsigned long long hash_hits;
+	unsigned long long hash_cutoffs;
+	unsigned long long endgame_solves;			/*nodes handed to the endgame solver*/
+	unsigned long long researches;				/*null-window scouts that failed high and were searched again*/
+	unsigned long long aspiration_failures;		/*root searches repeated with a wider window*/
+	unsigned long long mtdf_passes;				/*null-window root searches of MTD(f)*/
+	unsigned long long probcut_tries;			/*shallow ProbCut searches started*/
+	unsigned long long probcut_cuts;			/*nodes they cut*/
+}Search_Statistics;
+
+/*Main thread's progress when an iteration finished: time and nodes since the search started*/
+typedef struct
+{
+	int depth;
+	long long time;
+	unsigned long long nodes;
+}Depth_Report;
+
+typedef struct Reversi_Game Reversi_Game;
+
+typedef struct
+{
+	int pattern_index;
+	int power;									/*place value of the square in the pattern's base 3 index*/
+}Pattern_Link;
+
+/*Weight tables of the pattern evaluation, indexed by the base 3 configuration of a pattern's cells*/
+typedef struct
+{
+	int pattern_count;
+	int pattern_kinds[PATTERN_MAX_COUNT];
+	int pattern_lengths[PATTERN_KIND_COUNT];
+	int* kind_weights[PATTERN_KIND_COUNT];		/*value for black of every configuration*/
+	int* square_link_counts;
+	Pattern_Link* square_links;					/*PATTERN_MAX_COUNT slots per square: the patterns through it*/
+}Pattern_Evaluator;
+
+/*Position being searched. The generic board is changed in place; on 8x8 the bitboard is used instead, and on
+  other sizes up to 16x16 the wide bitboard*/
+typedef struct
+{
+	Reversi_Game* game;
+	Board_Cell** cells;
+	Bitboard_Position bitboard;					/*player_disks belong to player_to_move*/
+	bool use_bitboard;
+	bool use_wide_bitboard;						/*other sizes up to 16x16*/
+	Wide_Bitboard_Position wide_bitboard;		/*player_disks belong to player_to_move*/
+	bool use_frontier;							/*generic board: moves are only looked for on the workspace frontier*/
+	int player_to_move;
+	int empty_count;
+	int disk_counts[2];							/*by color index, kept for the generic board*/
+	Search_Workspace* workspace;				/*flip stack and move arena of the searching thread*/
+	int computer_color_index;					/*BLACK_INDEX or WHITE_INDEX, selects the zobrist keys*/
+	uint64_t hash_key;							/*zobrist hash of the disks and of the color to move*/
+	Pattern_Evaluator* patterns;				/*NULL when the disks are simply counted*/
+	int pattern_indices[PATTERN_MAX_COUNT];
+}Search_Position;
+
+typedef struct
+{
+	int square_index;
+	int flip_count;
+	int* flipped_squares;						/*generic board: points into the workspace flip stack*/
+	uint64_t flipped_disks;						/*bitboard*/
+	Wide_Bitboard wide_flipped_disks;
+	int frontier_changes;						/*frontier: neighbours that joined it, by direction, and FRONTIER_SQUARE_WAS_SET*/
+	uint64_t previous_hash_key;
+	int previous_pattern_indices[PATTERN_MAX_COUNT];
+}Move_Undo;
+
+typedef struct
+{
+	int value;
+	int16_t best_move;							/*square index, or -1 when no move raised alpha*/
+	uint8_t depth;								/*remaining search levels below the stored position*/
+	uint8_t bound;								/*TT_BOUND_*, and the generation at TT_GENERATION_SHIFT while stored*/
+}Transposition_Data;
+
+/*All search threads share the table without locks. The key is stored xor-ed with the packed data, so an entry
+  torn by two threads writing at once no longer matches its key and is skipped*/
+typedef struct
+{
+	uint64_t checked_key;
+	uint64_t data;
+}Transposition_Entry;
+
+typedef struct
+{
+	Transposition_Entry* entries;
+	size_t index_mask;
+	int generation;								/*entries stored in another generation count as empty*/
+}Transposition_Table;
+
+/*Opening book file: this header, then entry_count entries sorted by hash key, in the byte order of the machine
+  that built it*/
+typedef struct
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t board_size;
+	uint32_t entry_count;
+}Book_Header;
+
+typedef struct
+{
+	uint64_t hash_key;							/*get_board_hash_key of the position, with the color to move*/
+	int32_t value;								/*search value for the side to move*/
+	int16_t best_move;							/*square index*/
+	int16_t depth;								/*levels searched*/
+}Book_Entry;
+
+/*A book file mapped into memory; entries point into the mapping*/
+typedef struct
+{
+	void* mapped_data;
+	size_t mapped_size;
+	const Book_Entry* entries;
+	size_t entry_count;
+}Opening_Book;
+
+/*Deep value of a position as slope * shallow value + intercept, off by deviation on average*/
+typedef struct
+{
+	bool calibrated;
+	double slope;
+	double intercept;
+	double deviation;
+}Probcut_Fit;
+
+/*Everything a search thread changes while it searches; only the transposition table is shared*/
+typedef struct
+{
+	Reversi_Game* game;
+	Search_Workspace workspace;
+	Search_Position position;
+	Board_Cell** cells;							/*private copy of the game board for the generic search*/
+	int thread_index;
+	int search_depth_limit;						/*level of the current iteration, at most game_level*/
+	int principal_move;							/*best root move of the last finished iteration*/
+	int principal_value;						/*its value, the center of the next aspiration window*/
+	int earlier_principal_value;				/*value of the iteration before, of the same depth parity as the next*/
+	Search_Statistics statistics;
+	Thread_Handle handle;
+}Search_Thread;
+
+/*What pondering found for one reply of the user, kept to resume its deepening and to answer with it*/
+typedef struct
+{
+	int depth;									/*deepest finished iteration, 0 for none*/
+	int principal_move;
+	int principal_value;
+	int earlier_principal_value;
+	Search_Statistics statistics;
+}Ponder_Result;
 
-void switch_the_turn()
+
+/*Everything one game needs, so a process can hold any number of games side by side. Only the zobrist keys are
+  shared: they are constants, filled once by initialize_zobrist_keys before the first game is started*/
+struct Reversi_Game
+{
+	int board_size;
+	int game_level;
+	int current_turn;
+	int current_black_disks;
+	int current_white_disks;
+	char user_disk_color[6];
+	char computer_disk_color[6];
+	char* current_input_command;
+	Board_Cell** board;							/*NxN grid*/
+	Search_Thread* search_threads;
+	int search_thread_count;
+	Transposition_Table transposition_table;
+	int transposition_table_megabytes;
+	int move_time_limit;						/*milliseconds per computer move*/
+	long long game_clock_remaining;				/*milliseconds left for all computer moves*/
+	long long search_deadline;
+	volatile bool search_aborted;				/*set on timeout, or by the main thread to stop its helpers*/
+	volatile bool stop_requested;				/*set by the protocol's stop, checked with the clock*/
+	Search_Statistics last_search_statistics;
+	int last_search_depth;
+	int last_search_value;						/*disk differential for the computer*/
+	long long last_search_time;
+	Depth_Report* depth_reports;				/*one per finished iteration of the last search*/
+	int depth_report_count;
+	Search_Statistics game_statistics;
+	int computer_moves_searched;
+	long long game_search_time;
+	char stats_path[MENU_INPUT_LENGTH];			/*JSON lines file for search statistics, empty for none*/
+	FILE* stats_file;
+	bool move_ordering_enabled;
+	int mobility_sort_depth;
+	int endgame_empties;						/*positions with this many empty cells or fewer are solved, 0 disables*/
+	int endgame_mode;							/*ENDGAME_EXACT or ENDGAME_WIN_LOSS_DRAW*/
+	int evaluation;								/*EVALUATION_DISKS, EVALUATION_PATTERNS or EVALUATION_MOBILITY*/
+	int search_algorithm;						/*SEARCH_ALPHA_BETA, SEARCH_PRINCIPAL_VARIATION or SEARCH_MTDF*/
+	Pattern_Evaluator* patterns;
+	char book_path[MENU_INPUT_LENGTH];			/*opening book file, empty for none*/
+	Opening_Book opening_book;
+	char probcut_path[MENU_INPUT_LENGTH];		/*Multi-ProbCut calibration file, empty for none*/
+	double probcut_confidence;
+	bool probcut_enabled;
+	Probcut_Fit probcut_fits[MPC_STAGES][MPC_MAX_DEPTH + 1][MPC_CHECKS_PER_DEPTH];
+	bool pondering_enabled;						/*search the user's replies while waiting for the user's input*/
+	bool pondering;								/*the ponder thread is running*/
+	Search_Thread ponder_thread;
+	Board_Cell** ponder_board;					/*the game board after the reply being pondered*/
+	int* ponder_replies;
+	Ponder_Result* ponder_results;				/*by square of the reply*/
+	int ponder_reply;							/*square the user played after pondering, or INVALID_VALUE*/
+	int pondered_moves;							/*computer moves answered from pondering*/
+	char record_path[MENU_INPUT_LENGTH];		/*binary record of the game's moves, empty for none*/
+	FILE* record_file;
+	int record_color_to_move;					/*BLACK_INDEX or WHITE_INDEX*/
+	bool simd_enabled;							/*wide bitboards may use SSE2 and AVX2 kernels*/
+	Wide_Bitboard_Geometry wide_geometry;
+	const Wide_Bitboard_Kernels* wide_kernels;	/*NULL unless the board size is searched on wide bitboards*/
+	bool leaf_batching_enabled;					/*8x8 children at the horizon are evaluated together instead of played*/
+	const Leaf_Batch_Kernel* leaf_kernel;		/*NULL unless the board size and the evaluation allow leaf batches*/
+};
+
+uint64_t zobrist_disk_keys[2][MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+uint64_t zobrist_white_to_move_key;
+
+void switch_the_turn(Reversi_Game* game)
 {
-	if (current_turn == COMPUTER_TURN)
+	if (game->current_turn == COMPUTER_TURN)
 	{
-		current_turn = USER_TURN;
+		game->current_turn = USER_TURN;
 	}
-	else if (current_turn == USER_TURN)
+	else if (game->current_turn == USER_TURN)
 	{
-		current_turn = COMPUTER_TURN;
+		game->current_turn = COMPUTER_TURN;
 	}
 }
 
@@ -159,9 +640,9 @@ bool is_empty_cell(Board_Cell** current_board, Cell_Coordinates coordinates)
 	return false;
 }
 
-bool is_cell_within_board_boundary(Cell_Coordinates coordinates)
+bool is_cell_within_board_boundary(Reversi_Game* game, Cell_Coordinates coordinates)
 {
-	if (coordinates.row_index >= 0 && coordinates.row_index < board_size && coordinates.column_index >= 0 && coordinates.column_index < board_size)
+	if (coordinates.row_index >= 0 && coordinates.row_index < game->board_size && coordinates.column_index >= 0 && coordinates.column_index < game->board_size)
 	{
 		return true;
 	}
@@ -180,38 +661,39 @@ char get_character_from_color(char* color)
 	}
 }
 
-bool is_move_allowed(int** move_board, Cell_Coordinates coordinates)
+bool is_move_allowed(Reversi_Game* game, Move_List* valid_moves, Cell_Coordinates coordinates)
 {
-	if (move_board[coordinates.row_index][coordinates.column_index] == MOVE_ALLOWED)
+	int square_index = coordinates.row_index * game->board_size + coordinates.column_index;
+
+	if (!is_cell_within_board_boundary(game, coordinates))
 	{
-		return true;
+		return false;
 	}
-	return false;
-}
-
-bool no_valid_moves_exist(int** moves_board)
-{
-	for (int i = 0; i < board_size; i++)
+	for (int i = 0; i < valid_moves->count; i++)
 	{
-		for (int j = 0; j < board_size;j++)
+		if (valid_moves->moves[i] == square_index)
 		{
-			if (moves_board[i][j] == MOVE_ALLOWED)
-			{
-				return false;
-			}
+			return true;
 		}
 	}
-	return true;
+	return false;
+}
+
+bool no_valid_moves_exist(Move_List* valid_moves)
+{
+	return valid_moves->count == ZERO;
 }
 
-void update_disks_count(Board_Cell** current_board)
+/*Recounts the disks of the game board; register_move keeps them up to date, so this is only needed when the
+  board is set up directly*/
+void update_disks_count(Reversi_Game* game, Board_Cell** current_board)
 {
 	int w_count = ZERO;
 	int b_count = ZERO;
 
-	for(int i = 0; i < board_size; i++)
+	for(int i = 0; i < game->board_size; i++)
 	{
-		for (int j = 0; j < board_size; j++)
+		for (int j = 0; j < game->board_size; j++)
 		{
 			if (current_board[i][j].cell_disk_color == 'W')
 			{
@@ -224,43 +706,25 @@ void update_disks_count(Board_Cell** current_board)
 		}
 	}
 
-	current_black_disks = b_count;
-	current_white_disks = w_count;
+	game->current_black_disks = b_count;
+	game->current_white_disks = w_count;
 }
 
-int get_the_score(Board_Cell** current_board, int player_type)
+/*Disk differential of player_type on the game board, from the counts kept by register_move*/
+int get_the_score(Reversi_Game* game, int player_type)
 {
-	int net_score = 0;
-	char player_color, opponent_color;
-	Cell_Coordinates current_coordinates;
+	int net_score = game->current_black_disks - game->current_white_disks;
+	char player_color;
 
 	if (player_type == USER_PLAYER)
 	{
-		player_color = get_character_from_color(user_disk_color);
-		opponent_color = get_character_from_color(computer_disk_color);
+		player_color = get_character_from_color(game->user_disk_color);
 	}
 	else
 	{
-		player_color = get_character_from_color(computer_disk_color);
-		opponent_color = get_character_from_color(user_disk_color);
-	}
-
-
-	for (current_coordinates.row_index = 0; current_coordinates.row_index < board_size; current_coordinates.row_index++)
-	{
-		for (current_coordinates.column_index = 0; current_coordinates.column_index < board_size; current_coordinates.column_index++)
-		{
-			if (current_board[current_coordinates.row_index][current_coordinates.column_index].cell_disk_color == player_color)
-			{
-				net_score++;
-			}
-			else if (current_board[current_coordinates.row_index][current_coordinates.column_index].cell_disk_color == opponent_color)
-			{
-				net_score--;
-			}
-		}
+		player_color = get_character_from_color(game->computer_disk_color);
 	}
-	return net_score;
+	return player_color == 'B' ? net_score : -net_score;
 }
 
 int min(int a, int b)
@@ -281,23 +745,46 @@ int max(int a, int b)
 	return b;
 }
 
-Board_Cell** create_the_board()
+/*Smallest int not below value, kept inside the search values*/
+int round_up(double value)
+{
+	int truncated;
+
+	if (value >= VERY_POSITIVE_VALUE)
+	{
+		return VERY_POSITIVE_VALUE;
+	}
+	if (value <= VERY_NEGATIVE_VALUE)
+	{
+		return VERY_NEGATIVE_VALUE;
+	}
+	truncated = (int)value;
+	return value > truncated ? truncated + 1 : truncated;
+}
+
+/*Largest int not above value, kept inside the search values*/
+int round_down(double value)
+{
+	return -round_up(-value);
+}
+
+Board_Cell** create_the_board(Reversi_Game* game)
 {
 	Board_Cell** board;
 
-	board = (Board_Cell**)malloc(board_size * sizeof(Board_Cell*));
+	board = (Board_Cell**)malloc(game->board_size * sizeof(Board_Cell*));
 
 	//printf("\n ");
-	for (int i = 0; i < board_size; i++)
+	for (int i = 0; i < game->board_size; i++)
 	{
-		board[i] = (Board_Cell*)malloc(board_size * sizeof(Board_Cell));
+		board[i] = (Board_Cell*)malloc(game->board_size * sizeof(Board_Cell));
 		//printf("   %c", i + 'a');
 	}
 
-	for (int i = 0; i < board_size; i++)
+	for (int i = 0; i < game->board_size; i++)
 	{
 		
-		for (int j = 0; j < board_size; j++)
+		for (int j = 0; j < game->board_size; j++)
 		{
 			board[i][j].cell_coordinates.board_row = i + 1;
 			board[i][j].cell_coordinates.row_index = i;
@@ -305,19 +792,19 @@ Board_Cell** create_the_board()
 			board[i][j].cell_coordinates.board_column = j + 'a';
 			
 
-			if (i + 1 == board_size / 2 && j + 1 == board_size / 2)
+			if (i + 1 == game->board_size / 2 && j + 1 == game->board_size / 2)
 			{
 				board[i][j].cell_disk_color = 'W';
 			}
-			else if (i + 1 == board_size / 2 && j + 1 == (board_size / 2) +1)
+			else if (i + 1 == game->board_size / 2 && j + 1 == (game->board_size / 2) +1)
 			{
 				board[i][j].cell_disk_color = 'B';
 			}
-			else if (i + 1 == (board_size / 2) + 1 && j + 1 == board_size / 2)
+			else if (i + 1 == (game->board_size / 2) + 1 && j + 1 == game->board_size / 2)
 			{
 				board[i][j].cell_disk_color = 'B';
 			}
-			else if (i + 1 == (board_size / 2) + 1 && j + 1 == (board_size / 2) + 1)
+			else if (i + 1 == (game->board_size / 2) + 1 && j + 1 == (game->board_size / 2) + 1)
 			{
 				board[i][j].cell_disk_color = 'W';
 			}
@@ -331,9 +818,9 @@ Board_Cell** create_the_board()
 	return board;
 }
 
-void delete_the_board(Board_Cell** current_board)
+void delete_the_board(Reversi_Game* game, Board_Cell** current_board)
 {
-	for (int i = 0; i < board_size; i++)
+	for (int i = 0; i < game->board_size; i++)
 	{
 		if (current_board[i] != NULL)
 		{
@@ -346,25 +833,27 @@ void delete_the_board(Board_Cell** current_board)
 	}
 }
 
-void display_the_board(Board_Cell** current_board, int** allowed_moves_board, bool display_with_next_moves)
+void display_the_board(Reversi_Game* game, Board_Cell** current_board, Move_List* allowed_moves, bool display_with_next_moves)
 {
-	for (int i = 0;i < board_size;i++)
+	for (int i = 0;i < game->board_size;i++)
 	{
 		printf("   %c", i + 'a');
 	}
 
-	for (int i = 0; i < board_size; i++)
+	for (int i = 0; i < game->board_size; i++)
 	{
 		printf("\n  +");
-		for (int j = 0;j < board_size;j++)
+		for (int j = 0;j < game->board_size;j++)
 		{
 			printf("---+");
 		}
 		printf("\n%d |", i + 1);
 
-		for (int j = 0; j < board_size; j++)
+		for (int j = 0; j < game->board_size; j++)
 		{
-			if (display_with_next_moves == true && allowed_moves_board[i][j] == MOVE_ALLOWED)
+			Cell_Coordinates coordinates = { i + 1, i, j + 'a', j };
+
+			if (display_with_next_moves == true && is_move_allowed(game, allowed_moves, coordinates))
 			{
 				printf(" * |");
 			}
@@ -376,146 +865,105 @@ void display_the_board(Board_Cell** current_board, int** allowed_moves_board, bo
 	}
 	printf("\n  +");
 
-	for (int j = 0;j < board_size;j++)
+	for (int j = 0;j < game->board_size;j++)
 	{
 		printf("---+");
 	}
 	printf("\n");
 }
 
-void copy_the_board(Board_Cell** source_board, Board_Cell** destination_board)
+void copy_the_board(Reversi_Game* game, Board_Cell** source_board, Board_Cell** destination_board)
 {
-	for (int i = 0; i < board_size;i++)
+	for (int i = 0; i < game->board_size;i++)
 	{
-		for (int j = 0; j < board_size; j++)
+		for (int j = 0; j < game->board_size; j++)
 		{
 			source_board[i][j].cell_disk_color = destination_board[i][j].cell_disk_color;
 		}
 	}
 }
 
-int** create_valid_moves_board()
-{
-	int** valid_moves_board;
-	valid_moves_board = (int**)malloc(board_size * sizeof(int*));
-
-	for (int i = 0; i < board_size; i++)
-	{
-		valid_moves_board[i] = (int*)malloc(board_size * sizeof(int));
-	}
-	for (int i = 0; i < board_size; i++)
-	{
-		for (int j = 0; j < board_size;j++)
-		{
-			valid_moves_board[i][j] = MOVE_NOT_ALLOWED;
-		}
-	}
-	return valid_moves_board;
-}
-
-void delete_valid_moves_board(int** valid_moves_board)
-{
-	for (int i = 0; i < board_size; i++)
-	{
-		if (valid_moves_board[i] != NULL)
-		{
-			free(valid_moves_board[i]);
-		}
-	}
-	if (valid_moves_board != NULL)
-	{
-		free(valid_moves_board);
-	}
-}
-
-void update_valid_moves_board(Board_Cell** current_board,  int** valid_moves_board, int player_type)
+/*Whether the empty cell at coordinates is a move for player_color: some line of opponent disks next to it ends on
+  a player disk. Only the directions whose first cell holds an opponent disk are followed*/
+bool is_move_cell(Reversi_Game* game, Board_Cell** current_board, Cell_Coordinates coordinates, char player_color, char opponent_color)
 {
-	int opponent_player;
-	char player_color, opponent_color;
-	Cell_Coordinates current_coordinates = { INVALID_VALUE, INVALID_VALUE, ' ', INVALID_VALUE };
 	Cell_Coordinates delta_coordinates = { INVALID_VALUE, INVALID_VALUE, ' ', INVALID_VALUE };
 
-	if (player_type == USER_PLAYER)
-	{
-		player_color = get_character_from_color(user_disk_color);
-		opponent_color = get_character_from_color(computer_disk_color);
-		opponent_player = COMPUTER_PLAYER;
-	}
-	else
-	{
-		player_color = get_character_from_color(computer_disk_color);
-		opponent_color = get_character_from_color(user_disk_color);
-		opponent_player = USER_PLAYER;
-	}
-
-	for (current_coordinates.row_index = 0; current_coordinates.row_index < board_size; current_coordinates.row_index++)
+	for (delta_coordinates.row_index = -1; delta_coordinates.row_index <= 1; delta_coordinates.row_index++)
 	{
-		for (current_coordinates.column_index = 0; current_coordinates.column_index < board_size; current_coordinates.column_index++)
+		for (delta_coordinates.column_index = -1; delta_coordinates.column_index <= 1; delta_coordinates.column_index++)
 		{
-			if (!is_empty_cell(current_board, current_coordinates))
+			Cell_Coordinates temp_coordinates;
+			temp_coordinates.row_index = coordinates.row_index + delta_coordinates.row_index;
+			temp_coordinates.column_index = coordinates.column_index + delta_coordinates.column_index;
+
+			if (!is_cell_within_board_boundary(game, temp_coordinates) || (delta_coordinates.row_index == 0 && delta_coordinates.column_index == 0))
 			{
 				continue;
 			}
 
-
-			for (delta_coordinates.row_index = -1; delta_coordinates.row_index <= 1; delta_coordinates.row_index++)
+			if (is_opponent_disk(current_board, temp_coordinates, opponent_color))
 			{
-				for (delta_coordinates.column_index = -1; delta_coordinates.column_index <= 1; delta_coordinates.column_index++)
+				for (;;)
 				{
-					Cell_Coordinates temp_coordinates;
-					temp_coordinates.row_index = current_coordinates.row_index + delta_coordinates.row_index;
-					temp_coordinates.column_index = current_coordinates.column_index + delta_coordinates.column_index;
+					temp_coordinates.row_index += delta_coordinates.row_index;
+					temp_coordinates.column_index += delta_coordinates.column_index;
 
-					
-					if (!is_cell_within_board_boundary(temp_coordinates) || (delta_coordinates.row_index == 0 && delta_coordinates.column_index == 0))
+					if (!is_cell_within_board_boundary(game, temp_coordinates))
 					{
-						continue;
+						break;
 					}
-
-					if (is_opponent_disk(current_board, temp_coordinates, opponent_color))
+					if (is_empty_cell(current_board, temp_coordinates))
 					{
-						
-						for (;;)
-						{
-							temp_coordinates.row_index += delta_coordinates.row_index;
-							temp_coordinates.column_index += delta_coordinates.column_index;
-							
-							if (!is_cell_within_board_boundary(temp_coordinates))
-							{
-								break;
-							}
-							if (is_empty_cell(current_board, temp_coordinates))
-							{
-								break;
-							}
-							if (is_player_disk(current_board, temp_coordinates, player_color))
-							{
-								valid_moves_board[current_coordinates.row_index][current_coordinates.column_index] = MOVE_ALLOWED;
-								break;
-							}
-						}
+						break;
+					}
+					if (is_player_disk(current_board, temp_coordinates, player_color))
+					{
+						return true;
 					}
-
 				}
 			}
 		}
 	}
+	return false;
 }
 
-void copy_the_valid_moves_board(int** source_valid_board, int** destination_valid_board)
+/*Appends every legal move of player_type to valid_moves, in row-major order*/
+void generate_moves(Reversi_Game* game, Board_Cell** current_board, int player_type, Move_List* valid_moves)
 {
-	for (int i = 0; i < board_size;i++)
+	char player_color, opponent_color;
+	Cell_Coordinates current_coordinates = { INVALID_VALUE, INVALID_VALUE, ' ', INVALID_VALUE };
+
+	if (player_type == USER_PLAYER)
+	{
+		player_color = get_character_from_color(game->user_disk_color);
+		opponent_color = get_character_from_color(game->computer_disk_color);
+	}
+	else
+	{
+		player_color = get_character_from_color(game->computer_disk_color);
+		opponent_color = get_character_from_color(game->user_disk_color);
+	}
+
+	for (current_coordinates.row_index = 0; current_coordinates.row_index < game->board_size; current_coordinates.row_index++)
 	{
-		for (int j = 0; j < board_size; j++)
+		for (current_coordinates.column_index = 0; current_coordinates.column_index < game->board_size; current_coordinates.column_index++)
 		{
-			source_valid_board[i][j] = destination_valid_board[i][j];
+			if (is_empty_cell(current_board, current_coordinates) && is_move_cell(game, current_board, current_coordinates, player_color, opponent_color))
+			{
+				valid_moves->moves[valid_moves->count++] = current_coordinates.row_index * game->board_size + current_coordinates.column_index;
+			}
 		}
 	}
 }
 
-void register_move(Board_Cell** current_board, Cell_Coordinates choosen_move_coordinates, int player_type)
+/*Plays the move on current_board and returns the number of flipped disks. When flipped_squares is not NULL the
+  packed index (row_index * board_size + column_index) of every flipped disk is written to it, so that
+  undo_move_in_place can restore the board without a copy*/
+int apply_move_in_place(Reversi_Game* game, Board_Cell** current_board, Cell_Coordinates choosen_move_coordinates, int player_type, int* flipped_squares)
 {
 	Cell_Coordinates delta_coordinates = {0, 0, ' ', 0};
+	int flip_count = ZERO;
 
 	char player_color;
 	char opponent_color;
@@ -523,14 +971,14 @@ void register_move(Board_Cell** current_board, Cell_Coordinates choosen_move_coo
 
 	if (player_type == USER_PLAYER)
 	{
-		player_color = get_character_from_color(user_disk_color);
-		opponent_color = get_character_from_color(computer_disk_color);
+		player_color = get_character_from_color(game->user_disk_color);
+		opponent_color = get_character_from_color(game->computer_disk_color);
 		opponent_player = COMPUTER_PLAYER;
 	}
 	else
 	{
-		player_color = get_character_from_color(computer_disk_color);
-		opponent_color = get_character_from_color(user_disk_color);
+		player_color = get_character_from_color(game->computer_disk_color);
+		opponent_color = get_character_from_color(game->user_disk_color);
 		opponent_player = USER_PLAYER;
 	}
 
@@ -544,7 +992,7 @@ void register_move(Board_Cell** current_board, Cell_Coordinates choosen_move_coo
 			temp_coordinates.row_index = choosen_move_coordinates.row_index + delta_coordinates.row_index;
 			temp_coordinates.column_index = choosen_move_coordinates.column_index + delta_coordinates.column_index;
 
-			if (!is_cell_within_board_boundary (temp_coordinates) || (delta_coordinates.row_index == 0 && delta_coordinates.column_index == 0))
+			if (!is_cell_within_board_boundary (game, temp_coordinates) || (delta_coordinates.row_index == 0 && delta_coordinates.column_index == 0))
 			{
 				continue;
 			}
@@ -556,7 +1004,7 @@ void register_move(Board_Cell** current_board, Cell_Coordinates choosen_move_coo
 					temp_coordinates.row_index += delta_coordinates.row_index;
 					temp_coordinates.column_index += delta_coordinates.column_index;
 
-					if (!is_cell_within_board_boundary(temp_coordinates))
+					if (!is_cell_within_board_boundary(game, temp_coordinates))
 					{
 						break;
 					}
@@ -571,6 +1019,11 @@ void register_move(Board_Cell** current_board, Cell_Coordinates choosen_move_coo
 						while (is_opponent_disk(current_board, temp_coordinates, opponent_color))
 						{
 							current_board[temp_coordinates.row_index][temp_coordinates.column_index].cell_disk_color = player_color;
+							if (flipped_squares != NULL)
+							{
+								flipped_squares[flip_count] = temp_coordinates.row_index * game->board_size + temp_coordinates.column_index;
+							}
+							flip_count++;
 							temp_coordinates.row_index -= delta_coordinates.row_index;
 							temp_coordinates.column_index -= delta_coordinates.column_index;
 						}
@@ -580,297 +1033,6655 @@ void register_move(Board_Cell** current_board, Cell_Coordinates choosen_move_coo
 			}
 		}
 	}
+	return flip_count;
 }
 
-Alpha_Beta_Return max_value(Board_Cell** current_board, int alpha_value, int beta_value, int search_level);
-
-Alpha_Beta_Return min_value(Board_Cell** current_board, int alpha_value, int beta_value, int search_level)
+void undo_move_in_place(Reversi_Game* game, Board_Cell** current_board, Cell_Coordinates choosen_move_coordinates, int player_type, int* flipped_squares, int flip_count)
 {
-	int temp_value = VERY_POSITIVE_VALUE;
-	Alpha_Beta_Return return_value = { INVALID_VALUE, INVALID_VALUE, INVALID_VALUE };
-	Alpha_Beta_Return temp_max_store;
-	Cell_Coordinates current_coordinates;
-	int moves = 0;
+	char opponent_color;
 
-	if (search_level == game_level)
+	if (player_type == USER_PLAYER)
 	{
-		return_value.value = get_the_score(current_board, COMPUTER_PLAYER);
-
-		return_value.row_index = INVALID_VALUE;
-		return_value.column_index = INVALID_VALUE;
-		return return_value;
+		opponent_color = get_character_from_color(game->computer_disk_color);
 	}
-
-	int** temp_valid_moves = create_valid_moves_board();
-
-	update_valid_moves_board(current_board, temp_valid_moves, USER_PLAYER);
-
-	for (current_coordinates.row_index = 0; current_coordinates.row_index < board_size; current_coordinates.row_index++)
+	else
 	{
-		for (current_coordinates.column_index = 0; current_coordinates.column_index < board_size; current_coordinates.column_index++)
-		{
-			if (!is_move_allowed(temp_valid_moves, current_coordinates))
-			{
-				continue;
-			}
-			Board_Cell** temp_board = create_the_board();
-			copy_the_board(temp_board, current_board);
-			register_move(temp_board, current_coordinates, USER_PLAYER);
-
+		opponent_color = get_character_from_color(game->user_disk_color);
+	}
 
-			temp_max_store = max_value(temp_board, alpha_value, beta_value, search_level + 1);
-			temp_value = min(temp_value, temp_max_store.value);
-			return_value.value = temp_value;
-			if (temp_value <= alpha_value)
-			{
-				delete_valid_moves_board(temp_valid_moves);
-				delete_the_board(temp_board);
-				return_value.row_index = current_coordinates.row_index;
-				return_value.column_index = current_coordinates.column_index;
-				return_value.value = temp_value;
+	current_board[choosen_move_coordinates.row_index][choosen_move_coordinates.column_index].cell_disk_color = ' ';
 
-				return return_value;
-			}
-			if (beta_value >= temp_value)
-			{
-				beta_value = temp_value;
-				return_value.row_index = current_coordinates.row_index;
-				return_value.column_index = current_coordinates.column_index;
-				return_value.value = beta_value;
-				global_beta_value = beta_value;
-			}
-			delete_the_board(temp_board);
-			moves++;
-		}
+	for (int i = 0; i < flip_count; i++)
+	{
+		current_board[flipped_squares[i] / game->board_size][flipped_squares[i] % game->board_size].cell_disk_color = opponent_color;
 	}
-	delete_valid_moves_board(temp_valid_moves);
-	return return_value;
 }
 
-
-Alpha_Beta_Return max_value(Board_Cell** current_board, int alpha_value, int beta_value, int search_level)
+/*Plays a move on current_board, the game board, and updates the disk counts from the flips*/
+void register_move(Reversi_Game* game, Board_Cell** current_board, Cell_Coordinates choosen_move_coordinates, int player_type)
 {
-	int temp_value = VERY_NEGATIVE_VALUE;
-	Alpha_Beta_Return return_value = { INVALID_VALUE, INVALID_VALUE, INVALID_VALUE };
-	Alpha_Beta_Return temp_min_store;
-	Cell_Coordinates current_coordinates;
-	int moves = 0;;
+	int flip_count = apply_move_in_place(game, current_board, choosen_move_coordinates, player_type, NULL);
+	char player_color = get_character_from_color(player_type == USER_PLAYER ? game->user_disk_color : game->computer_disk_color);
 
-	if (search_level == game_level)
+	if (player_color == 'B')
 	{
-		return_value.value = get_the_score(current_board, COMPUTER_PLAYER);
-
-		return_value.row_index = INVALID_VALUE;
-		return_value.column_index = INVALID_VALUE;
-		return return_value;
+		game->current_black_disks += flip_count + 1;
+		game->current_white_disks -= flip_count;
+	}
+	else
+	{
+		game->current_white_disks += flip_count + 1;
+		game->current_black_disks -= flip_count;
 	}
+}
 
-	int** temp_valid_moves = create_valid_moves_board();
+/*Maximum number of disks a single move can flip: at most board_size - 3 along each of the four lines through it*/
+int max_flips_per_move(Reversi_Game* game)
+{
+	return 4 * game->board_size;
+}
 
-	update_valid_moves_board(current_board, temp_valid_moves, COMPUTER_PLAYER);
+/*Words of a frontier bit set, one bit per square*/
+int get_frontier_word_count(Reversi_Game* game)
+{
+	return (game->board_size * game->board_size + 63) / 64;
+}
 
-	for (current_coordinates.row_index = 0; current_coordinates.row_index < board_size; current_coordinates.row_index++)
-	{
-		for (current_coordinates.column_index = 0; current_coordinates.column_index < board_size; current_coordinates.column_index++)
-		{
-			if (!is_move_allowed(temp_valid_moves, current_coordinates))
-			{
-				continue;
-			}
+/*Search scratch memory, allocated once per game so alpha_beta_search itself never touches the heap. The move arena
+  holds one full list per search level and per level of the endgame solver below it, plus room for the move-ordering
+  scores, for the reply count or pass check and for the command loop*/
+Search_Workspace create_search_workspace(Reversi_Game* game)
+{
+	Search_Workspace workspace;
+	int level_count = game->game_level + game->endgame_empties;
+
+	workspace.flip_stack = (int*)malloc((level_count + 1) * max_flips_per_move(game) * sizeof(int));
+	workspace.flip_stack_top = ZERO;
+	workspace.move_arena.capacity = (level_count + 3) * game->board_size * game->board_size;
+	workspace.move_arena.moves = (int*)malloc(workspace.move_arena.capacity * sizeof(int));
+	workspace.move_arena.top = ZERO;
+	workspace.killer_moves = (int*)malloc(game->game_level * KILLERS_PER_LEVEL * sizeof(int));
+	workspace.history_scores[0] = (int*)calloc(game->board_size * game->board_size, sizeof(int));
+	workspace.history_scores[1] = (int*)calloc(game->board_size * game->board_size, sizeof(int));
+	workspace.frontier = (uint64_t*)calloc(get_frontier_word_count(game), sizeof(uint64_t));
+
+	return workspace;
+}
 
-			Board_Cell** temp_board = create_the_board();
-			copy_the_board(temp_board, current_board);
-			register_move(temp_board, current_coordinates, COMPUTER_PLAYER);
+void delete_search_workspace(Search_Workspace* workspace)
+{
+	free(workspace->frontier);
+	free(workspace->history_scores[1]);
+	free(workspace->history_scores[0]);
+	free(workspace->killer_moves);
+	free(workspace->move_arena.moves);
+	free(workspace->flip_stack);
+}
 
-			temp_min_store = min_value(temp_board, alpha_value, beta_value, search_level + 1);
-			temp_value = max(temp_value, temp_min_store.value);
-			return_value.value = temp_value;
-			if (temp_value >= beta_value)
-			{
-				delete_valid_moves_board(temp_valid_moves);
-				delete_the_board(temp_board);
-				return_value.row_index = current_coordinates.row_index;
-				return_value.column_index = current_coordinates.column_index;
-				return_value.value = temp_value;
+/*Starts an empty list at the top of the arena; close it with push_move_list once it is filled*/
+Move_List begin_move_list(Move_Arena* arena)
+{
+	Move_List valid_moves;
 
-				
-				return return_value;
-			}
-			if (alpha_value <= temp_value)
-			{
-				alpha_value = temp_value;
-				return_value.row_index = current_coordinates.row_index;
-				return_value.column_index = current_coordinates.column_index;
-				return_value.value = alpha_value;
-				global_alpha_value = alpha_value;
-			}
-			if (search_level == ZERO)
-			{
-				alpha_value = global_alpha_value;
-			}
-			delete_the_board(temp_board);
-			moves++;
-		}
-	}
-	delete_valid_moves_board(temp_valid_moves);
-	return return_value;
+	valid_moves.moves = arena->moves + arena->top;
+	valid_moves.count = ZERO;
+
+	return valid_moves;
 }
 
-Cell_Coordinates alpha_beta_search(Board_Cell** current_board, int search_level)
+void push_move_list(Move_Arena* arena, Move_List* valid_moves)
 {
-	Cell_Coordinates selected_move_coordinate;
-	Alpha_Beta_Return return_value;
+	arena->top += valid_moves->count;
+}
 
-	global_alpha_value = VERY_NEGATIVE_VALUE;
-	global_beta_value = VERY_POSITIVE_VALUE;
+void pop_move_list(Move_Arena* arena, Move_List* valid_moves)
+{
+	arena->top -= valid_moves->count;
+}
 
-	return_value = max_value(current_board, VERY_NEGATIVE_VALUE, VERY_POSITIVE_VALUE, search_level);
+/*Valid moves of player_type taken from the workspace arena; release with release_valid_moves*/
+Move_List get_valid_moves(Reversi_Game* game, Search_Workspace* workspace, Board_Cell** current_board, int player_type)
+{
+	Move_List valid_moves = begin_move_list(&workspace->move_arena);
 
-	selected_move_coordinate.row_index = return_value.row_index;
-	selected_move_coordinate.column_index = return_value.column_index;
+	generate_moves(game, current_board, player_type, &valid_moves);
+	push_move_list(&workspace->move_arena, &valid_moves);
 
-	return selected_move_coordinate;
+	return valid_moves;
 }
 
-Cell_Coordinates play_computer_move()
+void release_valid_moves(Search_Workspace* workspace, Move_List* valid_moves)
 {
-	Cell_Coordinates computer_move_coodinates;
-	computer_move_coodinates = alpha_beta_search(board, ZERO);
+	pop_move_list(&workspace->move_arena, valid_moves);
+}
 
-	if (computer_move_coodinates.row_index == INVALID_VALUE && computer_move_coodinates.column_index == INVALID_VALUE)
+/******************/
+/*8x8 BITBOARDS*/
+/******************/
+
+/*Shift amounts and wrap masks for E, SE, S, SW, W, NW, N, NE; positive amounts shift left*/
+static const int bitboard_shift_amounts[BITBOARD_DIRECTIONS] = { 1, 9, 8, 7, -1, -9, -8, -7 };
+static const uint64_t bitboard_shift_masks[BITBOARD_DIRECTIONS] =
+{
+	BITBOARD_NOT_A_FILE, BITBOARD_NOT_A_FILE, 0xFFFFFFFFFFFFFFFFULL, BITBOARD_NOT_H_FILE,
+	BITBOARD_NOT_H_FILE, BITBOARD_NOT_H_FILE, 0xFFFFFFFFFFFFFFFFULL, BITBOARD_NOT_A_FILE
+};
+
+static inline uint64_t bitboard_shift(uint64_t disks, int direction)
+{
+	int amount = bitboard_shift_amounts[direction];
+
+	if (amount > 0)
+	{
+		return (disks << amount) & bitboard_shift_masks[direction];
+	}
+	return (disks >> -amount) & bitboard_shift_masks[direction];
+}
+
+static inline int bitboard_count_disks(uint64_t disks)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcountll(disks);
+#else
+	disks = disks - ((disks >> 1) & 0x5555555555555555ULL);
+	disks = (disks & 0x3333333333333333ULL) + ((disks >> 2) & 0x3333333333333333ULL);
+	disks = (disks + (disks >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((disks * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/*Returns the index of the lowest set bit and clears it; the mask must not be empty*/
+static inline int bitboard_pop_lowest_square(uint64_t* disks)
+{
+	int square_index;
+#if defined(__GNUC__) || defined(__clang__)
+	square_index = __builtin_ctzll(*disks);
+#else
+	square_index = bitboard_count_disks((*disks & (0 - *disks)) - 1);
+#endif
+	*disks &= *disks - 1;
+	return square_index;
+}
+
+uint64_t bitboard_get_moves(uint64_t player_disks, uint64_t opponent_disks)
+{
+	uint64_t empty_cells = ~(player_disks | opponent_disks);
+	uint64_t moves = 0;
+
+	for (int direction = 0; direction < BITBOARD_DIRECTIONS; direction++)
+	{
+		uint64_t candidates = bitboard_shift(player_disks, direction) & opponent_disks;
+
+		/*a line of opponent disks is at most six long on an 8x8 board*/
+		candidates |= bitboard_shift(candidates, direction) & opponent_disks;
+		candidates |= bitboard_shift(candidates, direction) & opponent_disks;
+		candidates |= bitboard_shift(candidates, direction) & opponent_disks;
+		candidates |= bitboard_shift(candidates, direction) & opponent_disks;
+		candidates |= bitboard_shift(candidates, direction) & opponent_disks;
+
+		moves |= bitboard_shift(candidates, direction) & empty_cells;
+	}
+	return moves;
+}
+
+uint64_t bitboard_get_flips(uint64_t player_disks, uint64_t opponent_disks, int square_index)
+{
+	uint64_t flips = 0;
+	uint64_t move = 1ULL << square_index;
+
+	for (int direction = 0; direction < BITBOARD_DIRECTIONS; direction++)
+	{
+		uint64_t line = 0;
+		uint64_t cursor = bitboard_shift(move, direction);
+
+		while (cursor & opponent_disks)
+		{
+			line |= cursor;
+			cursor = bitboard_shift(cursor, direction);
+		}
+		if (cursor & player_disks)
+		{
+			flips |= line;
+		}
+	}
+	return flips;
+}
+
+void bitboard_generate_moves(uint64_t moves, Move_List* valid_moves)
+{
+	while (moves != 0)
+	{
+		valid_moves->moves[valid_moves->count++] = bitboard_pop_lowest_square(&moves);
+	}
+}
+
+Bitboard_Position bitboard_from_board(Board_Cell** current_board, char player_color, char opponent_color)
+{
+	Bitboard_Position position = { 0, 0 };
+
+	for (int i = 0; i < BITBOARD_SIZE; i++)
+	{
+		for (int j = 0; j < BITBOARD_SIZE; j++)
+		{
+			if (current_board[i][j].cell_disk_color == player_color)
+			{
+				position.player_disks |= 1ULL << (i * BITBOARD_SIZE + j);
+			}
+			else if (current_board[i][j].cell_disk_color == opponent_color)
+			{
+				position.opponent_disks |= 1ULL << (i * BITBOARD_SIZE + j);
+			}
+		}
+	}
+	return position;
+}
+
+/******************/
+/*WIDE BITBOARDS*/
+/******************/
+
+/*Shifts of E, SE, S, SW, W, NW, N, NE on a board of board_size, with the edge masks that stop a shift from wrapping
+  into the next row. Positive amounts shift left, towards higher squares*/
+Wide_Bitboard_Geometry create_wide_bitboard_geometry(int board_size)
+{
+	Wide_Bitboard_Geometry geometry;
+	Wide_Bitboard not_first_column, not_last_column;
+	int shift_amounts[BITBOARD_DIRECTIONS] = { 1, board_size + 1, board_size, board_size - 1, -1, -(board_size + 1), -board_size, -(board_size - 1) };
+
+	memset(&geometry, 0, sizeof(geometry));
+	memset(&not_first_column, 0, sizeof(not_first_column));
+	memset(&not_last_column, 0, sizeof(not_last_column));
+	geometry.word_count = (board_size * board_size + 63) / 64;
+	for (int i = 0; i < board_size * board_size; i++)
+	{
+		geometry.board_mask.words[i / 64] |= 1ULL << (i % 64);
+		if (i % board_size != 0)
+		{
+			not_first_column.words[i / 64] |= 1ULL << (i % 64);
+		}
+		if (i % board_size != board_size - 1)
+		{
+			not_last_column.words[i / 64] |= 1ULL << (i % 64);
+		}
+	}
+	for (int direction = 0; direction < BITBOARD_DIRECTIONS; direction++)
+	{
+		/*same columns as the 8x8 masks: moving east lands off the first column, moving west off the last*/
+		static const int mask_kinds[BITBOARD_DIRECTIONS] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+
+		geometry.shift_amounts[direction] = shift_amounts[direction];
+		geometry.shift_masks[direction] = mask_kinds[direction] > 0 ? not_first_column : mask_kinds[direction] < 0 ? not_last_column : geometry.board_mask;
+	}
+	return geometry;
+}
+
+/*The scalar kernels take the word count as a constant from their wrappers below, so the compiler unrolls a copy of
+  each for one, two, three and four words*/
+static inline void wide_bitboard_shift(const Wide_Bitboard_Geometry* geometry, const uint64_t* disks, int direction, uint64_t* shifted, int word_count)
+{
+	int amount = geometry->shift_amounts[direction];
+	const uint64_t* mask = geometry->shift_masks[direction].words;
+
+	/*in place is fine: each word is written after the neighbour it borrows from is read*/
+	if (amount > 0)
+	{
+		for (int i = word_count - 1; i >= 0; i--)
+		{
+			shifted[i] = ((disks[i] << amount) | (i > 0 ? disks[i - 1] >> (64 - amount) : 0)) & mask[i];
+		}
+	}
+	else
+	{
+		for (int i = 0; i < word_count; i++)
+		{
+			shifted[i] = ((disks[i] >> -amount) | (i + 1 < word_count ? disks[i + 1] << (64 + amount) : 0)) & mask[i];
+		}
+	}
+}
+
+static inline bool wide_bitboard_intersects(const uint64_t* first, const uint64_t* second, int word_count)
+{
+	uint64_t common = 0;
+
+	for (int i = 0; i < word_count; i++)
+	{
+		common |= first[i] & second[i];
+	}
+	return common != 0;
+}
+
+static inline void get_wide_moves_scalar(const Wide_Bitboard_Geometry* geometry, const Wide_Bitboard* player_disks, const Wide_Bitboard* opponent_disks, Wide_Bitboard* moves, int word_count)
+{
+	uint64_t empty_cells[WIDE_BITBOARD_WORDS];
+	uint64_t candidates[WIDE_BITBOARD_WORDS];
+	uint64_t cursor[WIDE_BITBOARD_WORDS];
+
+	memset(moves, 0, sizeof(*moves));
+	for (int i = 0; i < word_count; i++)
+	{
+		empty_cells[i] = ~(player_disks->words[i] | opponent_disks->words[i]) & geometry->board_mask.words[i];
+	}
+	for (int direction = 0; direction < BITBOARD_DIRECTIONS; direction++)
+	{
+		/*the ends of the lines of opponent disks that start next to a player disk, one step further each round*/
+		wide_bitboard_shift(geometry, player_disks->words, direction, cursor, word_count);
+		for (int i = 0; i < word_count; i++)
+		{
+			cursor[i] &= opponent_disks->words[i];
+			candidates[i] = cursor[i];
+		}
+		while (wide_bitboard_intersects(cursor, cursor, word_count))
+		{
+			wide_bitboard_shift(geometry, cursor, direction, cursor, word_count);
+			for (int i = 0; i < word_count; i++)
+			{
+				cursor[i] &= opponent_disks->words[i];
+				candidates[i] |= cursor[i];
+			}
+		}
+		wide_bitboard_shift(geometry, candidates, direction, cursor, word_count);
+		for (int i = 0; i < word_count; i++)
+		{
+			moves->words[i] |= cursor[i] & empty_cells[i];
+		}
+	}
+}
+
+static inline void get_wide_flips_scalar(const Wide_Bitboard_Geometry* geometry, const Wide_Bitboard* player_disks, const Wide_Bitboard* opponent_disks, int square_index, Wide_Bitboard* flips, int word_count)
+{
+	uint64_t move[WIDE_BITBOARD_WORDS] = { 0 };
+
+	memset(flips, 0, sizeof(*flips));
+	move[square_index / 64] = 1ULL << (square_index % 64);
+	for (int direction = 0; direction < BITBOARD_DIRECTIONS; direction++)
+	{
+		uint64_t line[WIDE_BITBOARD_WORDS] = { 0 };
+		uint64_t cursor[WIDE_BITBOARD_WORDS];
+
+		wide_bitboard_shift(geometry, move, direction, cursor, word_count);
+		while (wide_bitboard_intersects(cursor, opponent_disks->words, word_count))
+		{
+			for (int i = 0; i < word_count; i++)
+			{
+				line[i] |= cursor[i];
+			}
+			wide_bitboard_shift(geometry, cursor, direction, cursor, word_count);
+		}
+		if (wide_bitboard_intersects(cursor, player_disks->words, word_count))
+		{
+			for (int i = 0; i < word_count; i++)
+			{
+				flips->words[i] |= line[i];
+			}
+		}
+	}
+}
+
+void get_wide_moves_1(const Wide_Bitboard_Geometry* geometry, const Wide_Bitboard* player_disks, const Wide_Bitboard* opponent_disks, Wide_Bitboard* moves)
+{
+	get_wide_moves_scalar(geometry, player_disks, opponent_disks, moves, 1);
+}
+
+void get_wide_flips_1(const Wide_Bitboard_Geometry* geometry, const Wide_Bitboard* player_disks, const Wide_Bitboard* opponent_disks, int square_index, Wide_Bitboard* flips)
+{
+	get_wide_flips_scalar(geometry, player_disks, opponent_disks, square_index, flips, 1);
+}
+
+void get_wide_moves_2(const Wide_Bitboard_Geometry* geometry, const Wide_Bitboard* player_disks, const Wide_Bitboard* opponent_disks, Wide_Bitboard* moves)
+{
+	get_wide_moves_scalar(geometry, player_disks, opponent_disks, moves, 2);
+}
+
+void get_wide_flips_2(const Wide_Bitboard_Geometry* geometry, const Wide_Bitboard* player_disks, const Wide_Bitboard* opponent_disks, int square_index, Wide_Bitboard* flips)
+{
+	get_wide_flips_scalar(geometry, player_disks, opponent_disks, square_index, flips, 2);
+}
+
+void get_wide_moves_3(const Wide_Bitboard_Geometry* geometry, const Wide_Bitboard* player_disks, const Wide_Bitboard* opponent_disks, Wide_Bitboard* moves)
+{
+	get_wide_moves_scalar(geometry, player_disks, opponent_disks, moves, 3);
+}
+
+void get_wide_flips_3(const Wide_Bitboard_Geometry* geometry, const Wide_Bitboard* player_disks, const Wide_Bitboard* opponent_disks, int square_index, Wide_Bitboard* flips)
+{
+	get_wide_flips_scalar(geometry, player_disks, opponent_disks, square_index, flips, 3);
+}
+
+void get_wide_moves_4(const Wide_Bitboard_Geometry* geometry, const Wide_Bitboard* player_disks, const Wide_Bitboard* opponent_disks, Wide_Bitboard* moves)
+{
+	get_wide_moves_scalar(geometry, player_disks, opponent_disks, moves, 4);
+}
+
+void get_wide_flips_4(const Wide_Bitboard_Geometry* geometry, const Wide_Bitboard* player_disks, const Wide_Bitboard* opponent_disks, int square_index, Wide_Bitboard* flips)
+{
+	get_wide_flips_scalar(geometry, player_disks, opponent_disks, square_index, flips, 4);
+}
+
+/*Indexed by word count*/
+static const Wide_Bitboard_Kernels wide_scalar_kernels[WIDE_BITBOARD_WORDS + 1] =
+{
+	{ NULL, NULL, NULL },
+	{ "scalar", get_wide_moves_1, get_wide_flips_1 },
+	{ "scalar", get_wide_moves_2, get_wide_flips_2 },
+	{ "scalar", get_wide_moves_3, get_wide_flips_3 },
+	{ "scalar", get_wide_moves_4, get_wide_flips_4 }
+};
+
+#ifdef WIDE_BITBOARD_SIMD
+/*Two words in one SSE2 register. A shift moves both 64-bit lanes and carries the bits that leave one lane into the
+  other through a byte shift of the register*/
+__attribute__((target("sse2"))) static inline __m128i sse2_wide_shift(__m128i disks, int amount, __m128i mask)
+{
+	if (amount > 0)
+	{
+		__m128i carry = _mm_slli_si128(_mm_srl_epi64(disks, _mm_cvtsi32_si128(64 - amount)), 8);
+
+		return _mm_and_si128(_mm_or_si128(_mm_sll_epi64(disks, _mm_cvtsi32_si128(amount)), carry), mask);
+	}
+	__m128i carry = _mm_srli_si128(_mm_sll_epi64(disks, _mm_cvtsi32_si128(64 + amount)), 8);
+
+	return _mm_and_si128(_mm_or_si128(_mm_srl_epi64(disks, _mm_cvtsi32_si128(-amount)), carry), mask);
+}
+
+__attribute__((target("sse2"))) static inline bool sse2_is_empty(__m128i disks)
+{
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(disks, _mm_setzero_si128())) == 0xFFFF;
+}
+
+__attribute__((target("sse2"))) void get_wide_moves_sse2(const Wide_Bitboard_Geometry* geometry, const Wide_Bitboard* player_disks, const Wide_Bitboard* opponent_disks, Wide_Bitboard* moves)
+{
+	__m128i player = _mm_loadu_si128((const __m128i*)player_disks->words);
+	__m128i opponent = _mm_loadu_si128((const __m128i*)opponent_disks->words);
+	__m128i empty_cells = _mm_andnot_si128(_mm_or_si128(player, opponent), _mm_loadu_si128((const __m128i*)geometry->board_mask.words));
+	__m128i all_moves = _mm_setzero_si128();
+
+	for (int direction = 0; direction < BITBOARD_DIRECTIONS; direction++)
+	{
+		int amount = geometry->shift_amounts[direction];
+		__m128i mask = _mm_loadu_si128((const __m128i*)geometry->shift_masks[direction].words);
+		__m128i cursor = _mm_and_si128(sse2_wide_shift(player, amount, mask), opponent);
+		__m128i candidates = cursor;
+
+		while (!sse2_is_empty(cursor))
+		{
+			cursor = _mm_and_si128(sse2_wide_shift(cursor, amount, mask), opponent);
+			candidates = _mm_or_si128(candidates, cursor);
+		}
+		all_moves = _mm_or_si128(all_moves, _mm_and_si128(sse2_wide_shift(candidates, amount, mask), empty_cells));
+	}
+	memset(moves, 0, sizeof(*moves));
+	_mm_storeu_si128((__m128i*)moves->words, all_moves);
+}
+
+__attribute__((target("sse2"))) void get_wide_flips_sse2(const Wide_Bitboard_Geometry* geometry, const Wide_Bitboard* player_disks, const Wide_Bitboard* opponent_disks, int square_index, Wide_Bitboard* flips)
+{
+	Wide_Bitboard move_disk = { { 0 } };
+	__m128i player = _mm_loadu_si128((const __m128i*)player_disks->words);
+	__m128i opponent = _mm_loadu_si128((const __m128i*)opponent_disks->words);
+	__m128i move;
+	__m128i all_flips = _mm_setzero_si128();
+
+	move_disk.words[square_index / 64] = 1ULL << (square_index % 64);
+	move = _mm_loadu_si128((const __m128i*)move_disk.words);
+	for (int direction = 0; direction < BITBOARD_DIRECTIONS; direction++)
+	{
+		int amount = geometry->shift_amounts[direction];
+		__m128i mask = _mm_loadu_si128((const __m128i*)geometry->shift_masks[direction].words);
+		__m128i line = _mm_setzero_si128();
+		__m128i cursor = sse2_wide_shift(move, amount, mask);
+
+		while (!sse2_is_empty(_mm_and_si128(cursor, opponent)))
+		{
+			line = _mm_or_si128(line, cursor);
+			cursor = sse2_wide_shift(cursor, amount, mask);
+		}
+		if (!sse2_is_empty(_mm_and_si128(cursor, player)))
+		{
+			all_flips = _mm_or_si128(all_flips, line);
+		}
+	}
+	memset(flips, 0, sizeof(*flips));
+	_mm_storeu_si128((__m128i*)flips->words, all_flips);
+}
+
+/*All four words in one AVX2 register. The bits that leave a lane are carried into the next one by a lane
+  permutation, with the lane they would wrap into cleared*/
+__attribute__((target("avx2"))) static inline __m256i avx2_wide_shift(__m256i disks, int amount, __m256i mask)
+{
+	if (amount > 0)
+	{
+		__m256i carry = _mm256_srl_epi64(disks, _mm_cvtsi32_si128(64 - amount));
+
+		carry = _mm256_blend_epi32(_mm256_permute4x64_epi64(carry, _MM_SHUFFLE(2, 1, 0, 3)), _mm256_setzero_si256(), 0x03);
+		return _mm256_and_si256(_mm256_or_si256(_mm256_sll_epi64(disks, _mm_cvtsi32_si128(amount)), carry), mask);
+	}
+	__m256i carry = _mm256_sll_epi64(disks, _mm_cvtsi32_si128(64 + amount));
+
+	carry = _mm256_blend_epi32(_mm256_permute4x64_epi64(carry, _MM_SHUFFLE(0, 3, 2, 1)), _mm256_setzero_si256(), 0xC0);
+	return _mm256_and_si256(_mm256_or_si256(_mm256_srl_epi64(disks, _mm_cvtsi32_si128(-amount)), carry), mask);
+}
+
+__attribute__((target("avx2"))) void get_wide_moves_avx2(const Wide_Bitboard_Geometry* geometry, const Wide_Bitboard* player_disks, const Wide_Bitboard* opponent_disks, Wide_Bitboard* moves)
+{
+	__m256i player = _mm256_loadu_si256((const __m256i*)player_disks->words);
+	__m256i opponent = _mm256_loadu_si256((const __m256i*)opponent_disks->words);
+	__m256i empty_cells = _mm256_andnot_si256(_mm256_or_si256(player, opponent), _mm256_loadu_si256((const __m256i*)geometry->board_mask.words));
+	__m256i all_moves = _mm256_setzero_si256();
+
+	for (int direction = 0; direction < BITBOARD_DIRECTIONS; direction++)
+	{
+		int amount = geometry->shift_amounts[direction];
+		__m256i mask = _mm256_loadu_si256((const __m256i*)geometry->shift_masks[direction].words);
+		__m256i cursor = _mm256_and_si256(avx2_wide_shift(player, amount, mask), opponent);
+		__m256i candidates = cursor;
+
+		while (!_mm256_testz_si256(cursor, cursor))
+		{
+			cursor = _mm256_and_si256(avx2_wide_shift(cursor, amount, mask), opponent);
+			candidates = _mm256_or_si256(candidates, cursor);
+		}
+		all_moves = _mm256_or_si256(all_moves, _mm256_and_si256(avx2_wide_shift(candidates, amount, mask), empty_cells));
+	}
+	_mm256_storeu_si256((__m256i*)moves->words, all_moves);
+}
+
+__attribute__((target("avx2"))) void get_wide_flips_avx2(const Wide_Bitboard_Geometry* geometry, const Wide_Bitboard* player_disks, const Wide_Bitboard* opponent_disks, int square_index, Wide_Bitboard* flips)
+{
+	Wide_Bitboard move_disk = { { 0 } };
+	__m256i player = _mm256_loadu_si256((const __m256i*)player_disks->words);
+	__m256i opponent = _mm256_loadu_si256((const __m256i*)opponent_disks->words);
+	__m256i move;
+	__m256i all_flips = _mm256_setzero_si256();
+
+	move_disk.words[square_index / 64] = 1ULL << (square_index % 64);
+	move = _mm256_loadu_si256((const __m256i*)move_disk.words);
+	for (int direction = 0; direction < BITBOARD_DIRECTIONS; direction++)
+	{
+		int amount = geometry->shift_amounts[direction];
+		__m256i mask = _mm256_loadu_si256((const __m256i*)geometry->shift_masks[direction].words);
+		__m256i line = _mm256_setzero_si256();
+		__m256i cursor = avx2_wide_shift(move, amount, mask);
+
+		while (!_mm256_testz_si256(cursor, opponent))
+		{
+			line = _mm256_or_si256(line, cursor);
+			cursor = avx2_wide_shift(cursor, amount, mask);
+		}
+		if (!_mm256_testz_si256(cursor, player))
+		{
+			all_flips = _mm256_or_si256(all_flips, line);
+		}
+	}
+	_mm256_storeu_si256((__m256i*)flips->words, all_flips);
+}
+
+static const Wide_Bitboard_Kernels wide_sse2_kernels = { "sse2", get_wide_moves_sse2, get_wide_flips_sse2 };
+static const Wide_Bitboard_Kernels wide_avx2_kernels = { "avx2", get_wide_moves_avx2, get_wide_flips_avx2 };
+#endif
+
+/*Picks the kernels for the board size: none for 8x8, which has its own bitboards, or past 16x16, where the
+  frontier is used. Two words take SSE2 and three or four AVX2 when the processor has it and simd is on; the
+  rest run the scalar specialisation of their word count*/
+void select_wide_bitboard_kernels(Reversi_Game* game)
+{
+	game->wide_kernels = NULL;
+	if (game->board_size == BITBOARD_SIZE || game->board_size > WIDE_BITBOARD_MAX_SIZE)
+	{
+		return;
+	}
+	game->wide_geometry = create_wide_bitboard_geometry(game->board_size);
+	game->wide_kernels = &wide_scalar_kernels[game->wide_geometry.word_count];
+#ifdef WIDE_BITBOARD_SIMD
+	if (game->simd_enabled)
+	{
+		__builtin_cpu_init();
+		if (game->wide_geometry.word_count == 2 && __builtin_cpu_supports("sse2"))
+		{
+			game->wide_kernels = &wide_sse2_kernels;
+		}
+		else if (game->wide_geometry.word_count > 2 && __builtin_cpu_supports("avx2"))
+		{
+			game->wide_kernels = &wide_avx2_kernels;
+		}
+	}
+#endif
+}
+
+Wide_Bitboard_Position wide_bitboard_from_board(Reversi_Game* game, Board_Cell** current_board, char player_color, char opponent_color)
+{
+	Wide_Bitboard_Position position;
+
+	memset(&position, 0, sizeof(position));
+	for (int i = 0; i < game->board_size * game->board_size; i++)
+	{
+		char disk_color = current_board[i / game->board_size][i % game->board_size].cell_disk_color;
+
+		if (disk_color == player_color)
+		{
+			position.player_disks.words[i / 64] |= 1ULL << (i % 64);
+		}
+		else if (disk_color == opponent_color)
+		{
+			position.opponent_disks.words[i / 64] |= 1ULL << (i % 64);
+		}
+	}
+	return position;
+}
+
+int wide_bitboard_count_disks(Reversi_Game* game, const Wide_Bitboard* disks)
+{
+	int disk_count = ZERO;
+
+	for (int i = 0; i < game->wide_geometry.word_count; i++)
+	{
+		disk_count += bitboard_count_disks(disks->words[i]);
+	}
+	return disk_count;
+}
+
+void wide_bitboard_generate_moves(Reversi_Game* game, const Wide_Bitboard* moves, Move_List* valid_moves)
+{
+	for (int i = 0; i < game->wide_geometry.word_count; i++)
+	{
+		uint64_t word_moves = moves->words[i];
+
+		while (word_moves != 0)
+		{
+			valid_moves->moves[valid_moves->count++] = i * 64 + bitboard_pop_lowest_square(&word_moves);
+		}
+	}
+}
+
+/******************/
+/*ZOBRIST HASHING*/
+/******************/
+
+/*splitmix64 with a fixed seed, so hash keys are the same from run to run*/
+uint64_t get_next_random_key(uint64_t* state)
+{
+	uint64_t key;
+
+	*state += 0x9E3779B97F4A7C15ULL;
+	key = *state;
+	key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+
+	return key ^ (key >> 31);
+}
+
+void initialize_zobrist_keys()
+{
+	uint64_t state = ZOBRIST_SEED;
+
+	for (int color_index = 0; color_index < 2; color_index++)
+	{
+		for (int square_index = 0; square_index < MAX_BOARD_SIZE * MAX_BOARD_SIZE; square_index++)
+		{
+			zobrist_disk_keys[color_index][square_index] = get_next_random_key(&state);
+		}
+	}
+	zobrist_white_to_move_key = get_next_random_key(&state);
+}
+
+int get_color_index(char disk_color)
+{
+	if (disk_color == 'W')
+	{
+		return WHITE_INDEX;
+	}
+	return BLACK_INDEX;
+}
+
+/*Hash of the disks on current_board and of the color that moves next*/
+uint64_t get_board_hash_key(Reversi_Game* game, Board_Cell** current_board, char color_to_move)
+{
+	uint64_t hash_key = 0;
+
+	for (int i = 0; i < game->board_size; i++)
+	{
+		for (int j = 0; j < game->board_size; j++)
+		{
+			if (current_board[i][j].cell_disk_color != ' ')
+			{
+				hash_key ^= zobrist_disk_keys[get_color_index(current_board[i][j].cell_disk_color)][i * game->board_size + j];
+			}
+		}
+	}
+	if (color_to_move == 'W')
+	{
+		hash_key ^= zobrist_white_to_move_key;
+	}
+	return hash_key;
+}
+
+/******************/
+/*TRANSPOSITION TABLE*/
+/******************/
+
+/*Rounds the requested size down to a power of two number of entries; 0 MB disables the table*/
+Transposition_Table create_transposition_table(int size_in_megabytes)
+{
+	Transposition_Table table = { NULL, 0, 0 };
+	size_t size_in_bytes = (size_t)size_in_megabytes * 1024 * 1024;
+	size_t entry_count = 2;
+
+	if (size_in_bytes < 2 * sizeof(Transposition_Entry))
+	{
+		return table;
+	}
+	while (entry_count * 2 * sizeof(Transposition_Entry) <= size_in_bytes)
+	{
+		entry_count *= 2;
+	}
+
+	table.entries = (Transposition_Entry*)calloc(entry_count, sizeof(Transposition_Entry));
+	if (table.entries != NULL)
+	{
+		table.index_mask = entry_count - 1;
+	}
+	return table;
+}
+
+void delete_transposition_table(Transposition_Table* table)
+{
+	free(table->entries);
+	table->entries = NULL;
+	table->index_mask = 0;
+}
+
+/*Whether a stored entry holds a result of the table's current generation*/
+static inline bool is_current_transposition_data(Transposition_Table* table, Transposition_Data* data)
+{
+	return (data->bound & TT_BOUND_MASK) != TT_BOUND_NONE && data->bound >> TT_GENERATION_SHIFT == table->generation;
+}
+
+/*Forgets every entry. Moving to the next generation is enough, since older entries count as empty; the memory is
+  only zeroed once every generation has been used*/
+void clear_transposition_table(Transposition_Table* table)
+{
+	if (table->entries == NULL)
+	{
+		return;
+	}
+	table->generation++;
+	if (table->generation == TT_GENERATIONS)
+	{
+		memset(table->entries, 0, (table->index_mask + 1) * sizeof(Transposition_Entry));
+		table->generation = 0;
+	}
+}
+
+/*Entries come in pairs: the first slot keeps the deepest result, the second always takes the latest one*/
+bool probe_transposition_table(Transposition_Table* table, uint64_t hash_key, Transposition_Data* data)
+{
+	Transposition_Entry* bucket;
+
+	if (table->entries == NULL)
+	{
+		return false;
+	}
+	bucket = &table->entries[hash_key & table->index_mask & ~(size_t)1];
+
+	for (int i = 0; i < 2; i++)
+	{
+		uint64_t stored_data = bucket[i].data;
+
+		if ((bucket[i].checked_key ^ stored_data) == hash_key)
+		{
+			memcpy(data, &stored_data, sizeof(*data));
+			if (is_current_transposition_data(table, data))
+			{
+				data->bound &= TT_BOUND_MASK;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/*A search that returned value inside the window (alpha_value, beta_value) is exact, otherwise it is a bound*/
+void store_transposition_entry(Transposition_Table* table, uint64_t hash_key, int depth, int value, int alpha_value, int beta_value, int best_move)
+{
+	Transposition_Entry* entry;
+	Transposition_Data data;
+	Transposition_Data stored;
+	uint64_t packed_data;
+
+	if (table->entries == NULL)
+	{
+		return;
+	}
+	entry = &table->entries[hash_key & table->index_mask & ~(size_t)1];
+	packed_data = entry->data;
+	memcpy(&stored, &packed_data, sizeof(stored));
+	if ((entry->checked_key ^ packed_data) != hash_key && is_current_transposition_data(table, &stored) && depth < stored.depth)
+	{
+		entry++;
+	}
+
+	data.value = value;
+	data.best_move = (int16_t)best_move;
+	data.depth = (uint8_t)min(depth, UINT8_MAX);
+
+	if (value <= alpha_value)
+	{
+		data.bound = TT_BOUND_UPPER;
+	}
+	else if (value >= beta_value)
+	{
+		data.bound = TT_BOUND_LOWER;
+	}
+	else
+	{
+		data.bound = TT_BOUND_EXACT;
+	}
+	data.bound |= (uint8_t)(table->generation << TT_GENERATION_SHIFT);
+
+	memcpy(&packed_data, &data, sizeof(packed_data));
+	entry->data = packed_data;
+	entry->checked_key = hash_key ^ packed_data;
+}
+
+/*True when the stored result is deep enough and settles the window, with the usable value in *value*/
+bool transposition_cutoff(Transposition_Data* entry, int depth, int alpha_value, int beta_value, int* value)
+{
+	if (entry->depth < depth)
+	{
+		return false;
+	}
+	if (entry->bound == TT_BOUND_EXACT
+		|| (entry->bound == TT_BOUND_LOWER && entry->value >= beta_value)
+		|| (entry->bound == TT_BOUND_UPPER && entry->value <= alpha_value))
+	{
+		*value = entry->value;
+		return true;
+	}
+	return false;
+}
+
+/******************/
+/*PATTERN EVALUATION*/
+/******************/
+
+/*Moves every pattern through square_index by digit_change times the square's place value*/
+static inline void shift_pattern_indices(Pattern_Evaluator* patterns, int* pattern_indices, int square_index, int digit_change)
+{
+	Pattern_Link* links = &patterns->square_links[square_index * PATTERN_MAX_COUNT];
+
+	for (int i = 0; i < patterns->square_link_counts[square_index]; i++)
+	{
+		pattern_indices[links[i].pattern_index] += digit_change * links[i].power;
+	}
+}
+
+/*Value of one pattern configuration for black; digits[k] is the cell k squares from the pattern's corner*/
+int get_pattern_configuration_value(int pattern_kind, int* digits, int length)
+{
+	int value = ZERO;
+
+	for (int k = 0; k < length; k++)
+	{
+		int sign = digits[k] == PATTERN_BLACK_DIGIT ? 1 : (digits[k] == PATTERN_WHITE_DIGIT ? -1 : ZERO);
+
+		if (pattern_kind == PATTERN_EDGE)
+		{
+			/*the C-square gives the corner away while the corner is empty*/
+			if (k == 0)
+			{
+				value += sign * PATTERN_CORNER_WEIGHT;
+			}
+			else if (k == 1 && digits[0] == PATTERN_EMPTY_DIGIT)
+			{
+				value -= sign * PATTERN_C_SQUARE_PENALTY;
+			}
+			else
+			{
+				value += sign * PATTERN_EDGE_WEIGHT;
+			}
+		}
+		else if (pattern_kind == PATTERN_CORNER_BLOCK)
+		{
+			/*the corner and the edge cells are scored by the edge patterns*/
+			if (k == PATTERN_BLOCK_SIZE + 1)
+			{
+				value += digits[0] == PATTERN_EMPTY_DIGIT ? -sign * PATTERN_X_SQUARE_PENALTY : sign * PATTERN_INNER_WEIGHT;
+			}
+			else if (k / PATTERN_BLOCK_SIZE > 0 && k % PATTERN_BLOCK_SIZE > 0)
+			{
+				value += sign * PATTERN_INNER_WEIGHT;
+			}
+		}
+		else if (k > 1)
+		{
+			value += sign * PATTERN_INNER_WEIGHT;
+		}
+	}
+
+	/*disks in an unbroken run from an owned corner along the edge can never be flipped*/
+	if (pattern_kind == PATTERN_EDGE && digits[0] != PATTERN_EMPTY_DIGIT)
+	{
+		int sign = digits[0] == PATTERN_BLACK_DIGIT ? 1 : -1;
+
+		for (int k = 0; k < length && digits[k] == digits[0]; k++)
+		{
+			value += sign * PATTERN_STABLE_WEIGHT;
+		}
+	}
+	return value;
+}
+
+void add_pattern(Pattern_Evaluator* patterns, int pattern_kind, int* squares, int length)
+{
+	int pattern_index = patterns->pattern_count++;
+	int power = 1;
+
+	patterns->pattern_kinds[pattern_index] = pattern_kind;
+	for (int k = 0; k < length; k++)
+	{
+		Pattern_Link* link = &patterns->square_links[squares[k] * PATTERN_MAX_COUNT + patterns->square_link_counts[squares[k]]++];
+
+		link->pattern_index = pattern_index;
+		link->power = power;
+		power *= 3;
+	}
+}
+
+/*Fills the weight table of a pattern kind from the value of each configuration*/
+int* create_pattern_weights(int pattern_kind, int length)
+{
+	int configuration_count = 1;
+	int digits[PATTERN_MAX_LENGTH];
+	int* weights;
+
+	for (int k = 0; k < length; k++)
+	{
+		configuration_count *= 3;
+	}
+	weights = (int*)malloc(configuration_count * sizeof(int));
+
+	for (int configuration = 0; configuration < configuration_count; configuration++)
+	{
+		int remaining = configuration;
+
+		for (int k = 0; k < length; k++)
+		{
+			digits[k] = remaining % 3;
+			remaining /= 3;
+		}
+		weights[configuration] = get_pattern_configuration_value(pattern_kind, digits, length);
+	}
+	return weights;
+}
+
+/*From every corner: the edge along the row and along the column, the 3x3 block and the diagonal, each at most
+  PATTERN_EDGE_LENGTH cells long. The tables are read-only once built and shared by all search threads*/
+Pattern_Evaluator* create_pattern_evaluator(int board_size)
+{
+	Pattern_Evaluator* patterns = (Pattern_Evaluator*)calloc(1, sizeof(Pattern_Evaluator));
+	int line_length = min(board_size, PATTERN_EDGE_LENGTH);
+	int squares[PATTERN_MAX_LENGTH];
+
+	patterns->square_link_counts = (int*)calloc(board_size * board_size, sizeof(int));
+	patterns->square_links = (Pattern_Link*)malloc(board_size * board_size * PATTERN_MAX_COUNT * sizeof(Pattern_Link));
+	patterns->pattern_lengths[PATTERN_EDGE] = line_length;
+	patterns->pattern_lengths[PATTERN_CORNER_BLOCK] = PATTERN_BLOCK_SIZE * PATTERN_BLOCK_SIZE;
+	patterns->pattern_lengths[PATTERN_DIAGONAL] = line_length;
+
+	for (int corner = 0; corner < 4; corner++)
+	{
+		int corner_row = corner / 2 == 0 ? 0 : board_size - 1;
+		int corner_column = corner % 2 == 0 ? 0 : board_size - 1;
+		int row_step = corner_row == 0 ? 1 : -1;
+		int column_step = corner_column == 0 ? 1 : -1;
+
+		for (int k = 0; k < line_length; k++)
+		{
+			squares[k] = corner_row * board_size + corner_column + k * column_step;
+		}
+		add_pattern(patterns, PATTERN_EDGE, squares, line_length);
+		for (int k = 0; k < line_length; k++)
+		{
+			squares[k] = (corner_row + k * row_step) * board_size + corner_column;
+		}
+		add_pattern(patterns, PATTERN_EDGE, squares, line_length);
+		for (int k = 0; k < PATTERN_BLOCK_SIZE * PATTERN_BLOCK_SIZE; k++)
+		{
+			squares[k] = (corner_row + k / PATTERN_BLOCK_SIZE * row_step) * board_size + corner_column + k % PATTERN_BLOCK_SIZE * column_step;
+		}
+		add_pattern(patterns, PATTERN_CORNER_BLOCK, squares, PATTERN_BLOCK_SIZE * PATTERN_BLOCK_SIZE);
+		for (int k = 0; k < line_length; k++)
+		{
+			squares[k] = (corner_row + k * row_step) * board_size + corner_column + k * column_step;
+		}
+		add_pattern(patterns, PATTERN_DIAGONAL, squares, line_length);
+	}
+
+	for (int pattern_kind = 0; pattern_kind < PATTERN_KIND_COUNT; pattern_kind++)
+	{
+		patterns->kind_weights[pattern_kind] = create_pattern_weights(pattern_kind, patterns->pattern_lengths[pattern_kind]);
+	}
+	return patterns;
+}
+
+void delete_pattern_evaluator(Pattern_Evaluator* patterns)
+{
+	for (int pattern_kind = 0; pattern_kind < PATTERN_KIND_COUNT; pattern_kind++)
+	{
+		free(patterns->kind_weights[pattern_kind]);
+	}
+	free(patterns->square_link_counts);
+	free(patterns->square_links);
+	free(patterns);
+}
+
+/*Index of every pattern for current_board, in base 3 with the cell nearest the corner lowest*/
+void get_pattern_indices(Pattern_Evaluator* patterns, Reversi_Game* game, Board_Cell** current_board, int* pattern_indices)
+{
+	memset(pattern_indices, 0, PATTERN_MAX_COUNT * sizeof(int));
+
+	for (int square_index = 0; square_index < game->board_size * game->board_size; square_index++)
+	{
+		char disk_color = current_board[square_index / game->board_size][square_index % game->board_size].cell_disk_color;
+
+		if (disk_color != ' ')
+		{
+			shift_pattern_indices(patterns, pattern_indices, square_index, disk_color == 'W' ? PATTERN_WHITE_DIGIT : PATTERN_BLACK_DIGIT);
+		}
+	}
+}
+
+/*Pattern value of the position from the computer's point of view: one table load per pattern*/
+int evaluate_patterns(Search_Position* position)
+{
+	Pattern_Evaluator* patterns = position->patterns;
+	int value = ZERO;
+
+	for (int i = 0; i < patterns->pattern_count; i++)
+	{
+		value += patterns->kind_weights[patterns->pattern_kinds[i]][position->pattern_indices[i]];
+	}
+	return position->computer_color_index == BLACK_INDEX ? value : -value;
+}
+
+/******************/
+/*SEARCH POSITION*/
+/******************/
+
+int get_opponent_player(int player_type)
+{
+	if (player_type == COMPUTER_PLAYER)
+	{
+		return USER_PLAYER;
+	}
+	return COMPUTER_PLAYER;
+}
+
+Cell_Coordinates get_coordinates_from_square(Reversi_Game* game, int square_index)
+{
+	Cell_Coordinates coordinates;
+
+	coordinates.row_index = square_index / game->board_size;
+	coordinates.column_index = square_index % game->board_size;
+	coordinates.board_row = coordinates.row_index + 1;
+	coordinates.board_column = coordinates.column_index + 'a';
+
+	return coordinates;
+}
+
+/*The frontier of the generic board is the set of empty squares next to a disk, the only squares a move can be
+  played on. A move takes its square off the frontier and adds the empty squares around it, and flips change
+  no square's emptiness, so make and unmake keep it up to date at the cost of eight neighbours*/
+int add_frontier_neighbours(Search_Position* position, int square_index)
+{
+	Reversi_Game* game = position->game;
+	uint64_t* frontier = position->workspace->frontier;
+	Cell_Coordinates coordinates = get_coordinates_from_square(game, square_index);
+	Cell_Coordinates neighbour;
+	int changes = ZERO;
+	int direction = ZERO;
+
+	if ((frontier[square_index / 64] & (1ULL << (square_index % 64))) != 0)
+	{
+		frontier[square_index / 64] &= ~(1ULL << (square_index % 64));
+		changes |= FRONTIER_SQUARE_WAS_SET;
+	}
+	for (int row_delta = -1; row_delta <= 1; row_delta++)
+	{
+		for (int column_delta = -1; column_delta <= 1; column_delta++)
+		{
+			if (row_delta == 0 && column_delta == 0)
+			{
+				continue;
+			}
+			neighbour.row_index = coordinates.row_index + row_delta;
+			neighbour.column_index = coordinates.column_index + column_delta;
+			if (is_cell_within_board_boundary(game, neighbour) && is_empty_cell(position->cells, neighbour))
+			{
+				int neighbour_index = neighbour.row_index * game->board_size + neighbour.column_index;
+
+				if ((frontier[neighbour_index / 64] & (1ULL << (neighbour_index % 64))) == 0)
+				{
+					frontier[neighbour_index / 64] |= 1ULL << (neighbour_index % 64);
+					changes |= 1 << direction;
+				}
+			}
+			direction++;
+		}
+	}
+	return changes;
+}
+
+/*Undoes add_frontier_neighbours from the changes it returned*/
+void remove_frontier_neighbours(Search_Position* position, int square_index, int changes)
+{
+	Reversi_Game* game = position->game;
+	uint64_t* frontier = position->workspace->frontier;
+	int direction = ZERO;
+
+	for (int row_delta = -1; row_delta <= 1; row_delta++)
+	{
+		for (int column_delta = -1; column_delta <= 1; column_delta++)
+		{
+			if (row_delta == 0 && column_delta == 0)
+			{
+				continue;
+			}
+			if ((changes & (1 << direction)) != 0)
+			{
+				int neighbour_index = square_index + row_delta * game->board_size + column_delta;
+
+				frontier[neighbour_index / 64] &= ~(1ULL << (neighbour_index % 64));
+			}
+			direction++;
+		}
+	}
+	if ((changes & FRONTIER_SQUARE_WAS_SET) != 0)
+	{
+		frontier[square_index / 64] |= 1ULL << (square_index % 64);
+	}
+}
+
+/*Fills the workspace frontier from the disks of the position*/
+void build_frontier(Search_Position* position)
+{
+	Reversi_Game* game = position->game;
+
+	memset(position->workspace->frontier, 0, get_frontier_word_count(game) * sizeof(uint64_t));
+	for (int i = 0; i < game->board_size * game->board_size; i++)
+	{
+		if (!is_empty_cell(position->cells, get_coordinates_from_square(game, i)))
+		{
+			add_frontier_neighbours(position, i);
+		}
+	}
+}
+
+/*Appends the moves of player_type to valid_moves in row-major order, like generate_moves, trying only the
+  frontier squares*/
+void generate_frontier_moves(Search_Position* position, int player_type, Move_List* valid_moves)
+{
+	Reversi_Game* game = position->game;
+	char player_color = get_character_from_color(player_type == USER_PLAYER ? game->user_disk_color : game->computer_disk_color);
+	char opponent_color = get_character_from_color(player_type == USER_PLAYER ? game->computer_disk_color : game->user_disk_color);
+	int word_count = get_frontier_word_count(game);
+
+	for (int word_index = 0; word_index < word_count; word_index++)
+	{
+		uint64_t squares = position->workspace->frontier[word_index];
+
+		while (squares != 0)
+		{
+			int square_index = word_index * 64 + bitboard_pop_lowest_square(&squares);
+
+			if (is_move_cell(game, position->cells, get_coordinates_from_square(game, square_index), player_color, opponent_color))
+			{
+				valid_moves->moves[valid_moves->count++] = square_index;
+			}
+		}
+	}
+}
+
+/*Moves of player_type on the generic board, from the frontier when the position keeps one*/
+void generate_generic_moves(Search_Position* position, int player_type, Move_List* valid_moves)
+{
+	if (position->use_frontier)
+	{
+		generate_frontier_moves(position, player_type, valid_moves);
+	}
+	else
+	{
+		generate_moves(position->game, position->cells, player_type, valid_moves);
+	}
+}
+
+Search_Position create_search_position(Reversi_Game* game, Board_Cell** current_board, int player_to_move, Search_Workspace* workspace)
+{
+	Search_Position position;
+
+	char computer_color = get_character_from_color(game->computer_disk_color);
+	char user_color = get_character_from_color(game->user_disk_color);
+
+	position.game = game;
+	position.cells = current_board;
+	position.player_to_move = player_to_move;
+	position.workspace = workspace;
+	position.use_bitboard = (game->board_size == BITBOARD_SIZE);
+	position.use_wide_bitboard = game->wide_kernels != NULL;
+	position.use_frontier = !position.use_bitboard && !position.use_wide_bitboard;
+	position.disk_counts[BLACK_INDEX] = ZERO;
+	position.disk_counts[WHITE_INDEX] = ZERO;
+	for (int i = 0; i < game->board_size * game->board_size; i++)
+	{
+		char disk_color = current_board[i / game->board_size][i % game->board_size].cell_disk_color;
+
+		if (disk_color != ' ')
+		{
+			position.disk_counts[get_color_index(disk_color)]++;
+		}
+	}
+	position.empty_count = game->board_size * game->board_size - position.disk_counts[BLACK_INDEX] - position.disk_counts[WHITE_INDEX];
+	position.computer_color_index = get_color_index(computer_color);
+	position.hash_key = get_board_hash_key(game, current_board, player_to_move == COMPUTER_PLAYER ? computer_color : user_color);
+	position.patterns = game->patterns;
+	if (position.patterns != NULL)
+	{
+		get_pattern_indices(position.patterns, game, current_board, position.pattern_indices);
+	}
+
+	if (position.use_bitboard)
+	{
+		if (player_to_move == COMPUTER_PLAYER)
+		{
+			position.bitboard = bitboard_from_board(current_board, computer_color, user_color);
+		}
+		else
+		{
+			position.bitboard = bitboard_from_board(current_board, user_color, computer_color);
+		}
+	}
+	if (position.use_wide_bitboard)
+	{
+		if (player_to_move == COMPUTER_PLAYER)
+		{
+			position.wide_bitboard = wide_bitboard_from_board(game, current_board, computer_color, user_color);
+		}
+		else
+		{
+			position.wide_bitboard = wide_bitboard_from_board(game, current_board, user_color, computer_color);
+		}
+	}
+	if (position.use_frontier)
+	{
+		build_frontier(&position);
+	}
+	return position;
+}
+
+/*Moves of the side to move, taken from the workspace arena; release with release_valid_moves*/
+Move_List get_search_moves(Search_Position* position)
+{
+	Move_List valid_moves = begin_move_list(&position->workspace->move_arena);
+
+	if (position->use_bitboard)
+	{
+		bitboard_generate_moves(bitboard_get_moves(position->bitboard.player_disks, position->bitboard.opponent_disks), &valid_moves);
+	}
+	else if (position->use_wide_bitboard)
+	{
+		Wide_Bitboard moves;
+
+		position->game->wide_kernels->get_moves(&position->game->wide_geometry, &position->wide_bitboard.player_disks, &position->wide_bitboard.opponent_disks, &moves);
+		wide_bitboard_generate_moves(position->game, &moves, &valid_moves);
+	}
+	else
+	{
+		generate_generic_moves(position, position->player_to_move, &valid_moves);
+	}
+	push_move_list(&position->workspace->move_arena, &valid_moves);
+
+	return valid_moves;
+}
+
+bool opponent_has_moves(Search_Position* position)
+{
+	bool has_moves;
+
+	if (position->use_bitboard)
+	{
+		return bitboard_get_moves(position->bitboard.opponent_disks, position->bitboard.player_disks) != 0;
+	}
+	if (position->use_wide_bitboard)
+	{
+		Wide_Bitboard moves;
+
+		position->game->wide_kernels->get_moves(&position->game->wide_geometry, &position->wide_bitboard.opponent_disks, &position->wide_bitboard.player_disks, &moves);
+		return wide_bitboard_count_disks(position->game, &moves) > ZERO;
+	}
+
+	Move_List valid_moves = begin_move_list(&position->workspace->move_arena);
+	generate_generic_moves(position, get_opponent_player(position->player_to_move), &valid_moves);
+	has_moves = !no_valid_moves_exist(&valid_moves);
+
+	return has_moves;
+}
+
+int get_mover_color_index(Search_Position* position)
+{
+	if (position->player_to_move == COMPUTER_PLAYER)
+	{
+		return position->computer_color_index;
+	}
+	return 1 - position->computer_color_index;
+}
+
+void make_search_move(Search_Position* position, int square_index, Move_Undo* move_undo)
+{
+	Reversi_Game* game = position->game;
+	int mover_color_index = get_mover_color_index(position);
+	uint64_t* mover_keys = zobrist_disk_keys[mover_color_index];
+	uint64_t* opponent_keys = zobrist_disk_keys[1 - mover_color_index];
+
+	int mover_digit = mover_color_index == BLACK_INDEX ? PATTERN_BLACK_DIGIT : PATTERN_WHITE_DIGIT;
+	int flip_digit_change = mover_digit - (PATTERN_BLACK_DIGIT + PATTERN_WHITE_DIGIT - mover_digit);
+
+	move_undo->square_index = square_index;
+	move_undo->previous_hash_key = position->hash_key;
+	position->hash_key ^= mover_keys[square_index] ^ zobrist_white_to_move_key;
+	if (position->patterns != NULL)
+	{
+		memcpy(move_undo->previous_pattern_indices, position->pattern_indices, sizeof(position->pattern_indices));
+		shift_pattern_indices(position->patterns, position->pattern_indices, square_index, mover_digit);
+	}
+
+	if (position->use_bitboard)
+	{
+		uint64_t player_disks = position->bitboard.player_disks;
+		uint64_t flips = bitboard_get_flips(player_disks, position->bitboard.opponent_disks, square_index);
+		uint64_t remaining_flips = flips;
+
+		move_undo->flipped_disks = flips;
+		position->bitboard.player_disks = position->bitboard.opponent_disks ^ flips;
+		position->bitboard.opponent_disks = player_disks | flips | (1ULL << square_index);
+
+		while (remaining_flips != 0)
+		{
+			int flipped_square = bitboard_pop_lowest_square(&remaining_flips);
+			position->hash_key ^= mover_keys[flipped_square] ^ opponent_keys[flipped_square];
+			if (position->patterns != NULL)
+			{
+				shift_pattern_indices(position->patterns, position->pattern_indices, flipped_square, flip_digit_change);
+			}
+		}
+	}
+	else if (position->use_wide_bitboard)
+	{
+		Wide_Bitboard* player_disks = &position->wide_bitboard.player_disks;
+		Wide_Bitboard* opponent_disks = &position->wide_bitboard.opponent_disks;
+		Wide_Bitboard* flips = &move_undo->wide_flipped_disks;
+
+		game->wide_kernels->get_flips(&game->wide_geometry, player_disks, opponent_disks, square_index, flips);
+		player_disks->words[square_index / 64] |= 1ULL << (square_index % 64);
+		for (int i = 0; i < game->wide_geometry.word_count; i++)
+		{
+			uint64_t remaining_flips = flips->words[i];
+			uint64_t mover_word = player_disks->words[i] | remaining_flips;
+
+			/*the sides swap: the opponent moves next*/
+			player_disks->words[i] = opponent_disks->words[i] ^ remaining_flips;
+			opponent_disks->words[i] = mover_word;
+			while (remaining_flips != 0)
+			{
+				int flipped_square = i * 64 + bitboard_pop_lowest_square(&remaining_flips);
+
+				position->hash_key ^= mover_keys[flipped_square] ^ opponent_keys[flipped_square];
+				if (position->patterns != NULL)
+				{
+					shift_pattern_indices(position->patterns, position->pattern_indices, flipped_square, flip_digit_change);
+				}
+			}
+		}
+	}
+	else
+	{
+		move_undo->flipped_squares = position->workspace->flip_stack + position->workspace->flip_stack_top;
+		move_undo->flip_count = apply_move_in_place(game, position->cells, get_coordinates_from_square(game, square_index), position->player_to_move, move_undo->flipped_squares);
+		position->workspace->flip_stack_top += move_undo->flip_count;
+		if (position->use_frontier)
+		{
+			move_undo->frontier_changes = add_frontier_neighbours(position, square_index);
+		}
+		position->disk_counts[mover_color_index] += move_undo->flip_count + 1;
+		position->disk_counts[1 - mover_color_index] -= move_undo->flip_count;
+
+		for (int i = 0; i < move_undo->flip_count; i++)
+		{
+			position->hash_key ^= mover_keys[move_undo->flipped_squares[i]] ^ opponent_keys[move_undo->flipped_squares[i]];
+			if (position->patterns != NULL)
+			{
+				shift_pattern_indices(position->patterns, position->pattern_indices, move_undo->flipped_squares[i], flip_digit_change);
+			}
+		}
+	}
+	position->player_to_move = get_opponent_player(position->player_to_move);
+	position->empty_count--;
+}
+
+void unmake_search_move(Search_Position* position, Move_Undo* move_undo)
+{
+	Reversi_Game* game = position->game;
+	position->player_to_move = get_opponent_player(position->player_to_move);
+	position->empty_count++;
+	position->hash_key = move_undo->previous_hash_key;
+	if (position->patterns != NULL)
+	{
+		memcpy(position->pattern_indices, move_undo->previous_pattern_indices, sizeof(position->pattern_indices));
+	}
+
+	if (position->use_bitboard)
+	{
+		uint64_t player_disks = position->bitboard.opponent_disks ^ move_undo->flipped_disks ^ (1ULL << move_undo->square_index);
+
+		position->bitboard.opponent_disks = position->bitboard.player_disks | move_undo->flipped_disks;
+		position->bitboard.player_disks = player_disks;
+	}
+	else if (position->use_wide_bitboard)
+	{
+		Wide_Bitboard* player_disks = &position->wide_bitboard.player_disks;
+		Wide_Bitboard* opponent_disks = &position->wide_bitboard.opponent_disks;
+
+		opponent_disks->words[move_undo->square_index / 64] ^= 1ULL << (move_undo->square_index % 64);
+		for (int i = 0; i < game->wide_geometry.word_count; i++)
+		{
+			uint64_t mover_word = opponent_disks->words[i] ^ move_undo->wide_flipped_disks.words[i];
+
+			opponent_disks->words[i] = player_disks->words[i] | move_undo->wide_flipped_disks.words[i];
+			player_disks->words[i] = mover_word;
+		}
+	}
+	else
+	{
+		int mover_color_index = get_mover_color_index(position);
+
+		position->workspace->flip_stack_top -= move_undo->flip_count;
+		position->disk_counts[mover_color_index] -= move_undo->flip_count + 1;
+		position->disk_counts[1 - mover_color_index] += move_undo->flip_count;
+		if (position->use_frontier)
+		{
+			remove_frontier_neighbours(position, move_undo->square_index, move_undo->frontier_changes);
+		}
+		undo_move_in_place(game, position->cells, get_coordinates_from_square(game, move_undo->square_index), position->player_to_move, move_undo->flipped_squares, move_undo->flip_count);
+	}
+}
+
+void pass_search_position(Search_Position* position)
+{
+	if (position->use_bitboard)
+	{
+		uint64_t player_disks = position->bitboard.player_disks;
+
+		position->bitboard.player_disks = position->bitboard.opponent_disks;
+		position->bitboard.opponent_disks = player_disks;
+	}
+	if (position->use_wide_bitboard)
+	{
+		Wide_Bitboard player_disks = position->wide_bitboard.player_disks;
+
+		position->wide_bitboard.player_disks = position->wide_bitboard.opponent_disks;
+		position->wide_bitboard.opponent_disks = player_disks;
+	}
+	position->player_to_move = get_opponent_player(position->player_to_move);
+	position->hash_key ^= zobrist_white_to_move_key;
+}
+
+/*Disk differential from the computer's point of view*/
+int evaluate_search_position(Search_Position* position)
+{
+	if (position->use_bitboard)
+	{
+		int net_score = bitboard_count_disks(position->bitboard.player_disks) - bitboard_count_disks(position->bitboard.opponent_disks);
+
+		return position->player_to_move == COMPUTER_PLAYER ? net_score : -net_score;
+	}
+	if (position->use_wide_bitboard)
+	{
+		int net_score = wide_bitboard_count_disks(position->game, &position->wide_bitboard.player_disks) - wide_bitboard_count_disks(position->game, &position->wide_bitboard.opponent_disks);
+
+		return position->player_to_move == COMPUTER_PLAYER ? net_score : -net_score;
+	}
+	return position->disk_counts[position->computer_color_index] - position->disk_counts[1 - position->computer_color_index];
+}
+
+/*Moves player_type would have in the position, whichever side is to move*/
+int count_player_moves(Search_Position* position, int player_type)
+{
+	bool is_mover = player_type == position->player_to_move;
+
+	if (position->use_bitboard)
+	{
+		uint64_t player_disks = is_mover ? position->bitboard.player_disks : position->bitboard.opponent_disks;
+		uint64_t opponent_disks = is_mover ? position->bitboard.opponent_disks : position->bitboard.player_disks;
+
+		return bitboard_count_disks(bitboard_get_moves(player_disks, opponent_disks));
+	}
+	if (position->use_wide_bitboard)
+	{
+		const Wide_Bitboard* player_disks = is_mover ? &position->wide_bitboard.player_disks : &position->wide_bitboard.opponent_disks;
+		const Wide_Bitboard* opponent_disks = is_mover ? &position->wide_bitboard.opponent_disks : &position->wide_bitboard.player_disks;
+		Wide_Bitboard moves;
+
+		position->game->wide_kernels->get_moves(&position->game->wide_geometry, player_disks, opponent_disks, &moves);
+		return wide_bitboard_count_disks(position->game, &moves);
+	}
+
+	Move_List valid_moves = begin_move_list(&position->workspace->move_arena);
+	generate_generic_moves(position, player_type, &valid_moves);
+
+	return valid_moves.count;
+}
+
+/*Corners held by player_type*/
+int count_player_corners(Search_Position* position, int player_type)
+{
+	Reversi_Game* game = position->game;
+	int last_index = game->board_size - 1;
+	int corner_squares[4] = { 0, last_index, last_index * game->board_size, last_index * game->board_size + last_index };
+	bool is_mover = player_type == position->player_to_move;
+	int color_index = player_type == COMPUTER_PLAYER ? position->computer_color_index : 1 - position->computer_color_index;
+	int corner_count = ZERO;
+
+	if (position->use_bitboard)
+	{
+		return bitboard_count_disks((is_mover ? position->bitboard.player_disks : position->bitboard.opponent_disks) & BITBOARD_CORNERS);
+	}
+	for (int i = 0; i < 4; i++)
+	{
+		int square_index = corner_squares[i];
+
+		if (position->use_wide_bitboard)
+		{
+			const Wide_Bitboard* disks = is_mover ? &position->wide_bitboard.player_disks : &position->wide_bitboard.opponent_disks;
+
+			corner_count += (int)((disks->words[square_index / 64] >> (square_index % 64)) & 1);
+		}
+		else
+		{
+			char disk_color = position->cells[square_index / game->board_size][square_index % game->board_size].cell_disk_color;
+
+			corner_count += disk_color != ' ' && get_color_index(disk_color) == color_index;
+		}
+	}
+	return corner_count;
+}
+
+/*The disk differential plus the difference in moves and in corners, weighted, from the computer's point of view.
+  Both sides' moves are counted whichever is to move, so siblings are scored alike*/
+int evaluate_mobility(Search_Position* position)
+{
+	int move_balance = count_player_moves(position, COMPUTER_PLAYER) - count_player_moves(position, USER_PLAYER);
+	int corner_balance = count_player_corners(position, COMPUTER_PLAYER) - count_player_corners(position, USER_PLAYER);
+
+	return evaluate_search_position(position) + MOBILITY_MOVE_WEIGHT * move_balance + MOBILITY_CORNER_WEIGHT * corner_balance;
+}
+
+/*Value of a position at the search horizon, from the computer's point of view*/
+int evaluate_search_leaf(Search_Position* position)
+{
+	if (position->patterns != NULL)
+	{
+		return evaluate_patterns(position);
+	}
+	if (position->game->evaluation == EVALUATION_MOBILITY)
+	{
+		return evaluate_mobility(position);
+	}
+	return evaluate_search_position(position);
+}
+
+/*Disks count for more than any leaf value once the game is over, so the search prefers a certain win*/
+int get_final_disk_weight(Search_Position* position)
+{
+	if (position->patterns != NULL)
+	{
+		return PATTERN_FINAL_DISK_WEIGHT;
+	}
+	return position->game->evaluation == EVALUATION_MOBILITY ? MOBILITY_FINAL_DISK_WEIGHT : 1;
+}
+
+/*Value of a finished game, from the computer's point of view*/
+int evaluate_finished_position(Search_Position* position)
+{
+	return evaluate_search_position(position) * get_final_disk_weight(position);
+}
+
+/*The evaluation an eval option names; unknown names are the disk count*/
+int get_evaluation_from_name(const char* name)
+{
+	if (strcmp(name, "patterns") == 0)
+	{
+		return EVALUATION_PATTERNS;
+	}
+	if (strcmp(name, "mobility") == 0)
+	{
+		return EVALUATION_MOBILITY;
+	}
+	return EVALUATION_DISKS;
+}
+
+const char* get_evaluation_name(int evaluation)
+{
+	if (evaluation == EVALUATION_PATTERNS)
+	{
+		return "patterns";
+	}
+	return evaluation == EVALUATION_MOBILITY ? "mobility" : "disks";
+}
+
+/******************/
+/*MOVE ORDERING*/
+/******************/
+
+bool is_corner_square(Reversi_Game* game, int square_index)
+{
+	int row_index = square_index / game->board_size;
+	int column_index = square_index % game->board_size;
+
+	return (row_index == 0 || row_index == game->board_size - 1) && (column_index == 0 || column_index == game->board_size - 1);
+}
+
+/*Number of replies the opponent has after square_index is played*/
+int count_opponent_replies(Search_Position* position, int square_index)
+{
+	Move_Undo move_undo;
+	int reply_count;
+
+	make_search_move(position, square_index, &move_undo);
+	if (position->use_bitboard)
+	{
+		reply_count = bitboard_count_disks(bitboard_get_moves(position->bitboard.player_disks, position->bitboard.opponent_disks));
+	}
+	else if (position->use_wide_bitboard)
+	{
+		Wide_Bitboard replies;
+
+		position->game->wide_kernels->get_moves(&position->game->wide_geometry, &position->wide_bitboard.player_disks, &position->wide_bitboard.opponent_disks, &replies);
+		reply_count = wide_bitboard_count_disks(position->game, &replies);
+	}
+	else
+	{
+		Move_List replies = get_search_moves(position);
+		reply_count = replies.count;
+		release_valid_moves(position->workspace, &replies);
+	}
+	unmake_search_move(position, &move_undo);
+
+	return reply_count;
+}
+
+/*Sorts valid_moves best first: the hash (or previous iteration's) move, corners, the two killers of this level,
+  then history scores. Deep enough nodes also prefer moves that leave the opponent few replies*/
+void order_moves(Search_Thread* thread, Move_List* valid_moves, int search_level, int hash_move)
+{
+	Reversi_Game* game = thread->game;
+	Search_Position* position = &thread->position;
+	Move_Arena* arena = &thread->workspace.move_arena;
+	int* move_scores;
+	int* killer_moves = thread->workspace.killer_moves + search_level * KILLERS_PER_LEVEL;
+	int* history_scores = thread->workspace.history_scores[position->player_to_move - 1];
+	bool sort_by_mobility = game->mobility_sort_depth > ZERO && thread->search_depth_limit - search_level >= game->mobility_sort_depth;
+
+	if (!game->move_ordering_enabled || valid_moves->count < 2)
+	{
+		return;
+	}
+
+	move_scores = arena->moves + arena->top;
+	arena->top += valid_moves->count;
+
+	for (int i = 0; i < valid_moves->count; i++)
+	{
+		int square_index = valid_moves->moves[i];
+
+		if (square_index == hash_move)
+		{
+			move_scores[i] = ORDER_HASH_MOVE_SCORE;
+		}
+		else if (is_corner_square(game, square_index))
+		{
+			move_scores[i] = ORDER_CORNER_SCORE;
+		}
+		else if (square_index == killer_moves[0])
+		{
+			move_scores[i] = ORDER_KILLER_SCORE + 1;
+		}
+		else if (square_index == killer_moves[1])
+		{
+			move_scores[i] = ORDER_KILLER_SCORE;
+		}
+		else
+		{
+			move_scores[i] = history_scores[square_index];
+			if (sort_by_mobility)
+			{
+				move_scores[i] += (game->board_size * game->board_size - count_opponent_replies(position, square_index)) << ORDER_MOBILITY_SHIFT;
+			}
+		}
+	}
+
+	/*insertion sort keeps the row-major order among equal scores*/
+	for (int i = 1; i < valid_moves->count; i++)
+	{
+		int square_index = valid_moves->moves[i];
+		int score = move_scores[i];
+		int j = i - 1;
+
+		while (j >= 0 && move_scores[j] < score)
+		{
+			valid_moves->moves[j + 1] = valid_moves->moves[j];
+			move_scores[j + 1] = move_scores[j];
+			j--;
+		}
+		valid_moves->moves[j + 1] = square_index;
+		move_scores[j + 1] = score;
+	}
+
+	arena->top -= valid_moves->count;
+}
+
+/*Called for the move that caused a cutoff at search_level*/
+void record_cutoff_move(Search_Thread* thread, int square_index, int search_level)
+{
+	Reversi_Game* game = thread->game;
+	Search_Workspace* workspace = &thread->workspace;
+	int* killer_moves = workspace->killer_moves + search_level * KILLERS_PER_LEVEL;
+	int* history_scores = workspace->history_scores[thread->position.player_to_move - 1];
+	int search_depth = thread->search_depth_limit - search_level;
+
+	if (killer_moves[0] != square_index)
+	{
+		killer_moves[1] = killer_moves[0];
+		killer_moves[0] = square_index;
+	}
+
+	history_scores[square_index] += search_depth * search_depth;
+	if (history_scores[square_index] > ORDER_HISTORY_LIMIT)
+	{
+		for (int i = 0; i < game->board_size * game->board_size; i++)
+		{
+			workspace->history_scores[0][i] /= 2;
+			workspace->history_scores[1][i] /= 2;
+		}
+	}
+}
+
+/*Killers only make sense within one search; history is kept but aged*/
+void prepare_move_ordering(Reversi_Game* game, Search_Workspace* workspace)
+{
+	for (int i = 0; i < game->game_level * KILLERS_PER_LEVEL; i++)
+	{
+		workspace->killer_moves[i] = INVALID_VALUE;
+	}
+	for (int i = 0; i < game->board_size * game->board_size; i++)
+	{
+		workspace->history_scores[0][i] /= 2;
+		workspace->history_scores[1][i] /= 2;
+	}
+}
+
+/******************/
+/*LEAF BATCHES*/
+/******************/
+
+/*One child at a time, without the hash keys, patterns and undo information of make_search_move*/
+void evaluate_leaf_batch_scalar(uint64_t player_disks, uint64_t opponent_disks, const int* squares, int count, bool with_mobility, int* values)
+{
+	for (int i = 0; i < count; i++)
+	{
+		uint64_t flips = bitboard_get_flips(player_disks, opponent_disks, squares[i]);
+		uint64_t mover_disks = player_disks | flips | (1ULL << squares[i]);
+		uint64_t other_disks = opponent_disks ^ flips;
+		int value = bitboard_count_disks(mover_disks) - bitboard_count_disks(other_disks);
+
+		if (with_mobility)
+		{
+			value += MOBILITY_MOVE_WEIGHT * (bitboard_count_disks(bitboard_get_moves(mover_disks, other_disks)) - bitboard_count_disks(bitboard_get_moves(other_disks, mover_disks)));
+			value += MOBILITY_CORNER_WEIGHT * (bitboard_count_disks(mover_disks & BITBOARD_CORNERS) - bitboard_count_disks(other_disks & BITBOARD_CORNERS));
+		}
+		values[i] = value;
+	}
+}
+
+static const Leaf_Batch_Kernel leaf_scalar_kernel = { "scalar", evaluate_leaf_batch_scalar };
+
+#ifdef WIDE_BITBOARD_SIMD
+/*bitboard_shift on each of the four 64-bit lanes*/
+__attribute__((target("avx2"))) static inline __m256i avx2_bitboard_shift(__m256i disks, int direction)
+{
+	int amount = bitboard_shift_amounts[direction];
+	__m256i mask = _mm256_set1_epi64x((long long)bitboard_shift_masks[direction]);
+
+	if (amount > 0)
+	{
+		return _mm256_and_si256(_mm256_sll_epi64(disks, _mm_cvtsi32_si128(amount)), mask);
+	}
+	return _mm256_and_si256(_mm256_srl_epi64(disks, _mm_cvtsi32_si128(-amount)), mask);
+}
+
+/*Population count of each lane: a nibble lookup per byte, summed over the lane's eight bytes*/
+__attribute__((target("avx2"))) static inline __m256i avx2_bitboard_count_disks(__m256i disks)
+{
+	const __m256i nibble_counts = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low_nibbles = _mm256_set1_epi8(0x0F);
+	__m256i low_counts = _mm256_shuffle_epi8(nibble_counts, _mm256_and_si256(disks, low_nibbles));
+	__m256i high_counts = _mm256_shuffle_epi8(nibble_counts, _mm256_and_si256(_mm256_srli_epi16(disks, 4), low_nibbles));
+
+	return _mm256_sad_epu8(_mm256_add_epi8(low_counts, high_counts), _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2"))) static inline __m256i avx2_bitboard_get_moves(__m256i player_disks, __m256i opponent_disks)
+{
+	__m256i empty_cells = _mm256_xor_si256(_mm256_or_si256(player_disks, opponent_disks), _mm256_set1_epi64x(-1));
+	__m256i moves = _mm256_setzero_si256();
+
+	for (int direction = 0; direction < BITBOARD_DIRECTIONS; direction++)
+	{
+		__m256i candidates = _mm256_and_si256(avx2_bitboard_shift(player_disks, direction), opponent_disks);
+
+		candidates = _mm256_or_si256(candidates, _mm256_and_si256(avx2_bitboard_shift(candidates, direction), opponent_disks));
+		candidates = _mm256_or_si256(candidates, _mm256_and_si256(avx2_bitboard_shift(candidates, direction), opponent_disks));
+		candidates = _mm256_or_si256(candidates, _mm256_and_si256(avx2_bitboard_shift(candidates, direction), opponent_disks));
+		candidates = _mm256_or_si256(candidates, _mm256_and_si256(avx2_bitboard_shift(candidates, direction), opponent_disks));
+		candidates = _mm256_or_si256(candidates, _mm256_and_si256(avx2_bitboard_shift(candidates, direction), opponent_disks));
+
+		moves = _mm256_or_si256(moves, _mm256_and_si256(avx2_bitboard_shift(candidates, direction), empty_cells));
+	}
+	return moves;
+}
+
+/*Four children at once, one per lane. A lane's line of opponent disks flips when a player disk bounds it, so the
+  flips of every direction are the fill from the move masked by that lane's bound test; lanes past count repeat
+  the first child and are dropped*/
+__attribute__((target("avx2"))) void evaluate_leaf_batch_avx2(uint64_t player_disks, uint64_t opponent_disks, const int* squares, int count, bool with_mobility, int* values)
+{
+	__m256i player = _mm256_set1_epi64x((long long)player_disks);
+	__m256i opponent = _mm256_set1_epi64x((long long)opponent_disks);
+	__m256i move = _mm256_sllv_epi64(_mm256_set1_epi64x(1), _mm256_setr_epi64x(squares[0], squares[min(1, count - 1)], squares[min(2, count - 1)], squares[min(3, count - 1)]));
+	__m256i flips = _mm256_setzero_si256();
+	__m256i mover_disks, other_disks, lane_values;
+	long long lane_results[LEAF_BATCH_WIDTH];
+
+	for (int direction = 0; direction < BITBOARD_DIRECTIONS; direction++)
+	{
+		__m256i line = _mm256_and_si256(avx2_bitboard_shift(move, direction), opponent);
+		__m256i unbounded;
+
+		line = _mm256_or_si256(line, _mm256_and_si256(avx2_bitboard_shift(line, direction), opponent));
+		line = _mm256_or_si256(line, _mm256_and_si256(avx2_bitboard_shift(line, direction), opponent));
+		line = _mm256_or_si256(line, _mm256_and_si256(avx2_bitboard_shift(line, direction), opponent));
+		line = _mm256_or_si256(line, _mm256_and_si256(avx2_bitboard_shift(line, direction), opponent));
+		line = _mm256_or_si256(line, _mm256_and_si256(avx2_bitboard_shift(line, direction), opponent));
+
+		unbounded = _mm256_cmpeq_epi64(_mm256_and_si256(avx2_bitboard_shift(line, direction), player), _mm256_setzero_si256());
+		flips = _mm256_or_si256(flips, _mm256_andnot_si256(unbounded, line));
+	}
+	mover_disks = _mm256_or_si256(_mm256_or_si256(player, flips), move);
+	other_disks = _mm256_xor_si256(opponent, flips);
+	lane_values = _mm256_sub_epi64(avx2_bitboard_count_disks(mover_disks), avx2_bitboard_count_disks(other_disks));
+
+	if (with_mobility)
+	{
+		__m256i corners = _mm256_set1_epi64x((long long)BITBOARD_CORNERS);
+		__m256i move_balance = _mm256_sub_epi64(avx2_bitboard_count_disks(avx2_bitboard_get_moves(mover_disks, other_disks)),
+			avx2_bitboard_count_disks(avx2_bitboard_get_moves(other_disks, mover_disks)));
+		__m256i corner_balance = _mm256_sub_epi64(avx2_bitboard_count_disks(_mm256_and_si256(mover_disks, corners)),
+			avx2_bitboard_count_disks(_mm256_and_si256(other_disks, corners)));
+
+		/*the balances are small signed values, whole in the low 32 bits that _mm256_mul_epi32 multiplies*/
+		lane_values = _mm256_add_epi64(lane_values, _mm256_mul_epi32(move_balance, _mm256_set1_epi64x(MOBILITY_MOVE_WEIGHT)));
+		lane_values = _mm256_add_epi64(lane_values, _mm256_mul_epi32(corner_balance, _mm256_set1_epi64x(MOBILITY_CORNER_WEIGHT)));
+	}
+	_mm256_storeu_si256((__m256i*)lane_results, lane_values);
+	for (int i = 0; i < count; i++)
+	{
+		values[i] = (int)lane_results[i];
+	}
+}
+
+static const Leaf_Batch_Kernel leaf_avx2_kernel = { "avx2", evaluate_leaf_batch_avx2 };
+#endif
+
+/*Leaf batches need the 8x8 bitboards and an evaluation the kernels compute: the disk count or mobility, not the
+  patterns, whose indices only make_search_move keeps. AVX2 is used when the processor has it and simd is on*/
+void select_leaf_batch_kernel(Reversi_Game* game)
+{
+	game->leaf_kernel = NULL;
+	if (!game->leaf_batching_enabled || game->board_size != BITBOARD_SIZE || game->evaluation == EVALUATION_PATTERNS)
+	{
+		return;
+	}
+	game->leaf_kernel = &leaf_scalar_kernel;
+#ifdef WIDE_BITBOARD_SIMD
+	if (game->simd_enabled)
+	{
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+		{
+			game->leaf_kernel = &leaf_avx2_kernel;
+		}
+	}
+#endif
+}
+
+/*Whether every child of the node at search_level is a horizon leaf that is evaluated, not solved by the endgame
+  solver, so that the node can take the children's values from batches instead of playing them*/
+bool children_form_leaf_batch(Search_Thread* thread, int search_level)
+{
+	Reversi_Game* game = thread->game;
+	Search_Position* position = &thread->position;
+
+	if (game->leaf_kernel == NULL || !position->use_bitboard || search_level + 1 != thread->search_depth_limit)
+	{
+		return false;
+	}
+	return game->endgame_empties == ZERO || position->empty_count - 1 > game->endgame_empties;
+}
+
+/*Values of the batch of children that starts at first_index, from the computer's point of view*/
+void evaluate_leaf_batch(Search_Thread* thread, const Move_List* valid_moves, int first_index, int* leaf_values)
+{
+	Reversi_Game* game = thread->game;
+	Search_Position* position = &thread->position;
+	int count = min(LEAF_BATCH_WIDTH, valid_moves->count - first_index);
+
+	game->leaf_kernel->evaluate_children(position->bitboard.player_disks, position->bitboard.opponent_disks, valid_moves->moves + first_index, count,
+		game->evaluation == EVALUATION_MOBILITY, leaf_values);
+	if (position->player_to_move != COMPUTER_PLAYER)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			leaf_values[i] = -leaf_values[i];
+		}
+	}
+}
+
+/******************/
+/*ALPHA-BETA SEARCH*/
+/******************/
+
+long long get_time_in_milliseconds()
+{
+#ifdef _WIN32
+	return (long long)GetTickCount64();
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+#endif
+}
+
+/*Counts the node and reports whether the running iteration has run out of time or was stopped*/
+bool search_time_is_up(Search_Thread* thread)
+{
+	Reversi_Game* game = thread->game;
+	thread->statistics.nodes++;
+
+	if (game->search_aborted)
+	{
+		return true;
+	}
+	if (game->search_deadline != NO_TIME_LIMIT && (thread->statistics.nodes % TIME_CHECK_INTERVAL) == ZERO
+		&& (game->stop_requested || get_time_in_milliseconds() >= game->search_deadline))
+	{
+		game->search_aborted = true;
+	}
+	return game->search_aborted;
+}
+
+/*Stands in for the search of a child whose value a leaf batch holds: the node is counted as that search would
+  count it, and the value is the computer's*/
+int visit_batched_leaf(Search_Thread* thread, const int* leaf_values, int child_index)
+{
+	if (!search_time_is_up(thread))
+	{
+		thread->statistics.leaf_evaluations++;
+	}
+	return leaf_values[child_index % LEAF_BATCH_WIDTH];
+}
+
+/*Records the node in the transposition table, unless its search was cut short*/
+void store_search_result(Search_Thread* thread, int search_level, Alpha_Beta_Return result, int alpha_value, int beta_value)
+{
+	Reversi_Game* game = thread->game;
+	int best_move = -1;
+
+	if (game->search_aborted)
+	{
+		return;
+	}
+	if (result.row_index != INVALID_VALUE)
+	{
+		best_move = result.row_index * game->board_size + result.column_index;
+	}
+	store_transposition_entry(&game->transposition_table, thread->position.hash_key, thread->search_depth_limit - search_level, result.value, alpha_value, beta_value, best_move);
+}
+
+/*store_search_result for a negamax node: the value and window are turned to the computer's point of view*/
+void store_principal_variation_result(Search_Thread* thread, int search_level, Alpha_Beta_Return result, int alpha_value, int beta_value)
+{
+	if (thread->position.player_to_move == COMPUTER_PLAYER)
+	{
+		store_search_result(thread, search_level, result, alpha_value, beta_value);
+		return;
+	}
+	result.value = -result.value;
+	store_search_result(thread, search_level, result, -beta_value, -alpha_value);
+}
+
+Alpha_Beta_Return max_value(Search_Thread* thread, int alpha_value, int beta_value, int search_level);
+int solve_endgame_for_computer(Search_Thread* thread, int alpha_value, int beta_value);
+bool probcut_cuts(Search_Thread* thread, int alpha_value, int beta_value, int search_level, int* cut_value);
+
+Alpha_Beta_Return min_value(Search_Thread* thread, int alpha_value, int beta_value, int search_level)
+{
+	Reversi_Game* game = thread->game;
+	Search_Position* position = &thread->position;
+	int temp_value = VERY_POSITIVE_VALUE;
+	Alpha_Beta_Return return_value = { INVALID_VALUE, INVALID_VALUE, INVALID_VALUE };
+	Alpha_Beta_Return temp_max_store;
+	Move_Undo move_undo;
+	int original_beta_value = beta_value;
+	int search_depth = thread->search_depth_limit - search_level;
+	int hash_move = INVALID_VALUE;
+	bool leaf_batch;
+	int leaf_values[LEAF_BATCH_WIDTH];
+
+	if (search_time_is_up(thread))
+	{
+		return return_value;
+	}
+	/*the root still picks the move, from its solved children*/
+	if (search_level > ZERO && game->endgame_empties > ZERO && position->empty_count <= game->endgame_empties)
+	{
+		return_value.value = solve_endgame_for_computer(thread, alpha_value, beta_value);
+		return return_value;
+	}
+	if (search_level == thread->search_depth_limit)
+	{
+		thread->statistics.leaf_evaluations++;
+		return_value.value = evaluate_search_leaf(position);
+		return return_value;
+	}
+
+	/*the root always searches, so that it has a move to return; it is ordered by the previous iteration instead*/
+	if (search_level > ZERO)
+	{
+		Transposition_Data entry;
+
+		thread->statistics.hash_probes++;
+		if (probe_transposition_table(&game->transposition_table, position->hash_key, &entry))
+		{
+			thread->statistics.hash_hits++;
+			if (transposition_cutoff(&entry, search_depth, alpha_value, beta_value, &return_value.value))
+			{
+				thread->statistics.hash_cutoffs++;
+				return return_value;
+			}
+			hash_move = entry.best_move;
+		}
+		if (game->probcut_enabled && probcut_cuts(thread, alpha_value, beta_value, search_level, &return_value.value))
+		{
+			return return_value;
+		}
+	}
+
+	Move_List valid_moves = get_search_moves(position);
+
+	/*the user has to pass: the game is over when the computer cannot move either*/
+	if (no_valid_moves_exist(&valid_moves))
+	{
+		release_valid_moves(position->workspace, &valid_moves);
+		if (!opponent_has_moves(position))
+		{
+			thread->statistics.leaf_evaluations++;
+			return_value.value = evaluate_finished_position(position);
+			return return_value;
+		}
+		pass_search_position(position);
+		temp_max_store = max_value(thread, alpha_value, beta_value, search_level + 1);
+		pass_search_position(position);
+
+		return_value.value = temp_max_store.value;
+		store_search_result(thread, search_level, return_value, alpha_value, original_beta_value);
+		return return_value;
+	}
+
+	order_moves(thread, &valid_moves, search_level, hash_move);
+	thread->statistics.interior_nodes++;
+	leaf_batch = children_form_leaf_batch(thread, search_level);
+
+	for (int i = 0; i < valid_moves.count; i++)
+	{
+		if (leaf_batch)
+		{
+			if (i % LEAF_BATCH_WIDTH == ZERO)
+			{
+				evaluate_leaf_batch(thread, &valid_moves, i, leaf_values);
+			}
+			temp_max_store.value = visit_batched_leaf(thread, leaf_values, i);
+		}
+		else
+		{
+			make_search_move(position, valid_moves.moves[i], &move_undo);
+			temp_max_store = max_value(thread, alpha_value, beta_value, search_level + 1);
+			unmake_search_move(position, &move_undo);
+		}
+
+		if (game->search_aborted)
+		{
+			break;
+		}
+		thread->statistics.moves_searched++;
+
+		temp_value = min(temp_value, temp_max_store.value);
+		return_value.value = temp_value;
+		if (temp_value <= alpha_value)
+		{
+			record_cutoff_move(thread, valid_moves.moves[i], search_level);
+			thread->statistics.cutoffs[min(i, CUTOFF_INDEX_SLOTS - 1)]++;
+			return_value.row_index = valid_moves.moves[i] / game->board_size;
+			return_value.column_index = valid_moves.moves[i] % game->board_size;
+			return_value.value = temp_value;
+			release_valid_moves(position->workspace, &valid_moves);
+			store_search_result(thread, search_level, return_value, alpha_value, original_beta_value);
+
+			return return_value;
+		}
+		if (temp_value < beta_value || return_value.row_index == INVALID_VALUE)
+		{
+			beta_value = min(beta_value, temp_value);
+			return_value.row_index = valid_moves.moves[i] / game->board_size;
+			return_value.column_index = valid_moves.moves[i] % game->board_size;
+			return_value.value = temp_value;
+		}
+	}
+	release_valid_moves(position->workspace, &valid_moves);
+	store_search_result(thread, search_level, return_value, alpha_value, original_beta_value);
+	return return_value;
+}
+
+
+Alpha_Beta_Return max_value(Search_Thread* thread, int alpha_value, int beta_value, int search_level)
+{
+	Reversi_Game* game = thread->game;
+	Search_Position* position = &thread->position;
+	int temp_value = VERY_NEGATIVE_VALUE;
+	Alpha_Beta_Return return_value = { INVALID_VALUE, INVALID_VALUE, INVALID_VALUE };
+	Alpha_Beta_Return temp_min_store;
+	Move_Undo move_undo;
+	int original_alpha_value = alpha_value;
+	int search_depth = thread->search_depth_limit - search_level;
+	int hash_move = search_level == ZERO ? thread->principal_move : INVALID_VALUE;
+	bool leaf_batch;
+	int leaf_values[LEAF_BATCH_WIDTH];
+
+	if (search_time_is_up(thread))
+	{
+		return return_value;
+	}
+	/*the root still picks the move, from its solved children*/
+	if (search_level > ZERO && game->endgame_empties > ZERO && position->empty_count <= game->endgame_empties)
+	{
+		return_value.value = solve_endgame_for_computer(thread, alpha_value, beta_value);
+		return return_value;
+	}
+	if (search_level == thread->search_depth_limit)
+	{
+		thread->statistics.leaf_evaluations++;
+		return_value.value = evaluate_search_leaf(position);
+		return return_value;
+	}
+
+	/*the root always searches, so that it has a move to return; it is ordered by the previous iteration instead*/
+	if (search_level > ZERO)
+	{
+		Transposition_Data entry;
+
+		thread->statistics.hash_probes++;
+		if (probe_transposition_table(&game->transposition_table, position->hash_key, &entry))
+		{
+			thread->statistics.hash_hits++;
+			if (transposition_cutoff(&entry, search_depth, alpha_value, beta_value, &return_value.value))
+			{
+				thread->statistics.hash_cutoffs++;
+				return return_value;
+			}
+			hash_move = entry.best_move;
+		}
+		if (game->probcut_enabled && probcut_cuts(thread, alpha_value, beta_value, search_level, &return_value.value))
+		{
+			return return_value;
+		}
+	}
+
+	Move_List valid_moves = get_search_moves(position);
+
+	/*the computer has to pass: the game is over when the user cannot move either*/
+	if (no_valid_moves_exist(&valid_moves))
+	{
+		release_valid_moves(position->workspace, &valid_moves);
+		if (!opponent_has_moves(position))
+		{
+			thread->statistics.leaf_evaluations++;
+			return_value.value = evaluate_finished_position(position);
+			return return_value;
+		}
+		pass_search_position(position);
+		temp_min_store = min_value(thread, alpha_value, beta_value, search_level + 1);
+		pass_search_position(position);
+
+		return_value.value = temp_min_store.value;
+		store_search_result(thread, search_level, return_value, original_alpha_value, beta_value);
+		return return_value;
+	}
+
+	order_moves(thread, &valid_moves, search_level, hash_move);
+	thread->statistics.interior_nodes++;
+	leaf_batch = children_form_leaf_batch(thread, search_level);
+
+	for (int i = 0; i < valid_moves.count; i++)
+	{
+		if (leaf_batch)
+		{
+			if (i % LEAF_BATCH_WIDTH == ZERO)
+			{
+				evaluate_leaf_batch(thread, &valid_moves, i, leaf_values);
+			}
+			temp_min_store.value = visit_batched_leaf(thread, leaf_values, i);
+		}
+		else
+		{
+			make_search_move(position, valid_moves.moves[i], &move_undo);
+			temp_min_store = min_value(thread, alpha_value, beta_value, search_level + 1);
+			unmake_search_move(position, &move_undo);
+		}
+
+		if (game->search_aborted)
+		{
+			break;
+		}
+		thread->statistics.moves_searched++;
+
+		temp_value = max(temp_value, temp_min_store.value);
+		return_value.value = temp_value;
+		if (temp_value >= beta_value)
+		{
+			record_cutoff_move(thread, valid_moves.moves[i], search_level);
+			thread->statistics.cutoffs[min(i, CUTOFF_INDEX_SLOTS - 1)]++;
+			return_value.row_index = valid_moves.moves[i] / game->board_size;
+			return_value.column_index = valid_moves.moves[i] % game->board_size;
+			return_value.value = temp_value;
+			release_valid_moves(position->workspace, &valid_moves);
+			store_search_result(thread, search_level, return_value, original_alpha_value, beta_value);
+
+			return return_value;
+		}
+		if (temp_value > alpha_value || return_value.row_index == INVALID_VALUE)
+		{
+			alpha_value = max(alpha_value, temp_value);
+			return_value.row_index = valid_moves.moves[i] / game->board_size;
+			return_value.column_index = valid_moves.moves[i] % game->board_size;
+			return_value.value = temp_value;
+		}
+	}
+	release_valid_moves(position->workspace, &valid_moves);
+	store_search_result(thread, search_level, return_value, original_alpha_value, beta_value);
+	return return_value;
+}
+
+/******************/
+/*PRINCIPAL VARIATION SEARCH*/
+/******************/
+
+/*Negamax form of max_value and min_value: values are from the side to move's point of view, and only the
+  transposition table, which is shared with them, keeps the computer's. The first move is searched with the full
+  window and the rest with a null window that only proves them worse, re-searched when one turns out better*/
+Alpha_Beta_Return principal_variation_search(Search_Thread* thread, int alpha_value, int beta_value, int search_level)
+{
+	Reversi_Game* game = thread->game;
+	Search_Position* position = &thread->position;
+	int sign = position->player_to_move == COMPUTER_PLAYER ? 1 : -1;
+	int best_value = VERY_NEGATIVE_VALUE;
+	Alpha_Beta_Return return_value = { INVALID_VALUE, INVALID_VALUE, INVALID_VALUE };
+	Alpha_Beta_Return child_value;
+	Move_Undo move_undo;
+	int original_alpha_value = alpha_value;
+	int search_depth = thread->search_depth_limit - search_level;
+	int hash_move = search_level == ZERO ? thread->principal_move : INVALID_VALUE;
+	bool leaf_batch;
+	int leaf_values[LEAF_BATCH_WIDTH];
+
+	if (search_time_is_up(thread))
+	{
+		return return_value;
+	}
+	if (search_level > ZERO && game->endgame_empties > ZERO && position->empty_count <= game->endgame_empties)
+	{
+		return_value.value = sign * (sign > 0 ? solve_endgame_for_computer(thread, alpha_value, beta_value) : solve_endgame_for_computer(thread, -beta_value, -alpha_value));
+		return return_value;
+	}
+	if (search_level == thread->search_depth_limit)
+	{
+		thread->statistics.leaf_evaluations++;
+		return_value.value = sign * evaluate_search_leaf(position);
+		return return_value;
+	}
+
+	if (search_level > ZERO)
+	{
+		Transposition_Data entry;
+
+		thread->statistics.hash_probes++;
+		if (probe_transposition_table(&game->transposition_table, position->hash_key, &entry))
+		{
+			thread->statistics.hash_hits++;
+			if (sign > 0 ? transposition_cutoff(&entry, search_depth, alpha_value, beta_value, &return_value.value)
+				: transposition_cutoff(&entry, search_depth, -beta_value, -alpha_value, &return_value.value))
+			{
+				thread->statistics.hash_cutoffs++;
+				return_value.value *= sign;
+				return return_value;
+			}
+			hash_move = entry.best_move;
+		}
+		if (game->probcut_enabled && (sign > 0 ? probcut_cuts(thread, alpha_value, beta_value, search_level, &return_value.value)
+			: probcut_cuts(thread, -beta_value, -alpha_value, search_level, &return_value.value)))
+		{
+			return_value.value *= sign;
+			return return_value;
+		}
+	}
+
+	Move_List valid_moves = get_search_moves(position);
+
+	if (no_valid_moves_exist(&valid_moves))
+	{
+		release_valid_moves(position->workspace, &valid_moves);
+		if (!opponent_has_moves(position))
+		{
+			thread->statistics.leaf_evaluations++;
+			return_value.value = sign * evaluate_finished_position(position);
+			return return_value;
+		}
+		pass_search_position(position);
+		child_value = principal_variation_search(thread, -beta_value, -alpha_value, search_level + 1);
+		pass_search_position(position);
+
+		return_value.value = -child_value.value;
+		store_principal_variation_result(thread, search_level, return_value, original_alpha_value, beta_value);
+		return return_value;
+	}
+
+	order_moves(thread, &valid_moves, search_level, hash_move);
+	thread->statistics.interior_nodes++;
+	leaf_batch = children_form_leaf_batch(thread, search_level);
+
+	for (int i = 0; i < valid_moves.count; i++)
+	{
+		int value;
+
+		if (leaf_batch)
+		{
+			if (i % LEAF_BATCH_WIDTH == ZERO)
+			{
+				evaluate_leaf_batch(thread, &valid_moves, i, leaf_values);
+			}
+			/*a leaf has one value whatever the window, so the re-search only counts the node again*/
+			value = sign * visit_batched_leaf(thread, leaf_values, i);
+			if (i > ZERO && value > alpha_value && value < beta_value && !game->search_aborted)
+			{
+				thread->statistics.researches++;
+				value = sign * visit_batched_leaf(thread, leaf_values, i);
+			}
+		}
+		else
+		{
+			make_search_move(position, valid_moves.moves[i], &move_undo);
+			if (i == ZERO)
+			{
+				value = -principal_variation_search(thread, -beta_value, -alpha_value, search_level + 1).value;
+			}
+			else
+			{
+				value = -principal_variation_search(thread, -alpha_value - 1, -alpha_value, search_level + 1).value;
+				if (value > alpha_value && value < beta_value && !game->search_aborted)
+				{
+					thread->statistics.researches++;
+					value = -principal_variation_search(thread, -beta_value, -alpha_value, search_level + 1).value;
+				}
+			}
+			unmake_search_move(position, &move_undo);
+		}
+
+		if (game->search_aborted)
+		{
+			break;
+		}
+		thread->statistics.moves_searched++;
+
+		if (value > best_value || return_value.row_index == INVALID_VALUE)
+		{
+			best_value = value;
+			return_value.row_index = valid_moves.moves[i] / game->board_size;
+			return_value.column_index = valid_moves.moves[i] % game->board_size;
+			return_value.value = value;
+		}
+		alpha_value = max(alpha_value, value);
+		if (alpha_value >= beta_value)
+		{
+			record_cutoff_move(thread, valid_moves.moves[i], search_level);
+			thread->statistics.cutoffs[min(i, CUTOFF_INDEX_SLOTS - 1)]++;
+			break;
+		}
+	}
+	release_valid_moves(position->workspace, &valid_moves);
+	store_principal_variation_result(thread, search_level, return_value, original_alpha_value, beta_value);
+	return return_value;
+}
+
+/******************/
+/*MULTI-PROBCUT*/
+/******************/
+
+/*Shallow search depth of check number check for a node with depth levels left. It keeps the parity of depth,
+  since disk counts swing between odd and even depths; check 1 is two levels shallower than check 0*/
+int get_probcut_shallow_depth(int depth, int check)
+{
+	int shallow_depth = (depth + 1) / 2;
+
+	if ((depth - shallow_depth) % 2 != 0)
+	{
+		shallow_depth--;
+	}
+	return shallow_depth - 2 * check;
+}
+
+/*Game stage by the share of empty cells, from the opening (0) to the endgame*/
+int get_probcut_stage(Reversi_Game* game, int empty_count)
+{
+	int cell_count = game->board_size * game->board_size;
+
+	return min(MPC_STAGES - 1, (cell_count - empty_count) * MPC_STAGES / cell_count);
+}
+
+/*The calibration file written by the probcut command: size and eval lines, then one fit per line*/
+bool load_probcut_fits(Reversi_Game* game, const char* path)
+{
+	FILE* fits_file = fopen(path, "r");
+	char line[MENU_INPUT_LENGTH];
+	char evaluation_name[MENU_INPUT_LENGTH];
+	int board_size = INVALID_VALUE;
+	int evaluation = EVALUATION_DISKS;
+	int fit_count = ZERO;
+
+	if (fits_file == NULL)
+	{
+		printf("Cannot open the ProbCut calibration %s\n", path);
+		return false;
+	}
+	while (fgets(line, sizeof(line), fits_file) != NULL)
+	{
+		int stage, depth, check, sample_count;
+		double slope, intercept, deviation;
+
+		if (line[0] == '#')
+		{
+			continue;
+		}
+		if (sscanf(line, "size %d", &board_size) == 1)
+		{
+			continue;
+		}
+		if (sscanf(line, "eval %255s", evaluation_name) == 1)
+		{
+			evaluation = get_evaluation_from_name(evaluation_name);
+			continue;
+		}
+		if (sscanf(line, "%d %d %d %lf %lf %lf %d", &stage, &depth, &check, &slope, &intercept, &deviation, &sample_count) == 7
+			&& stage >= 0 && stage < MPC_STAGES && depth >= MPC_MIN_DEPTH && depth <= MPC_MAX_DEPTH && check >= 0 && check < MPC_CHECKS_PER_DEPTH
+			&& slope > MPC_MIN_SLOPE)
+		{
+			Probcut_Fit* fit = &game->probcut_fits[stage][depth][check];
+
+			fit->calibrated = true;
+			fit->slope = slope;
+			fit->intercept = intercept;
+			fit->deviation = deviation;
+			fit_count++;
+		}
+	}
+	fclose(fits_file);
+
+	/*the fits are in the units of one evaluation on one board size*/
+	if (board_size != game->board_size || evaluation != game->evaluation)
+	{
+		printf("The ProbCut calibration %s is not for %dx%d boards with this evaluation\n", path, game->board_size, game->board_size);
+		memset(game->probcut_fits, 0, sizeof(game->probcut_fits));
+		return false;
+	}
+	return fit_count > ZERO;
+}
+
+/*Searches the node at search_level depth levels deep with the game's algorithm, with a window and a result for the side to move*/
+int search_probcut_shallow(Search_Thread* thread, int alpha_value, int beta_value, int search_level, int depth)
+{
+	int saved_depth_limit = thread->search_depth_limit;
+	int value;
+
+	thread->search_depth_limit = search_level + depth;
+	if (thread->game->search_algorithm == SEARCH_PRINCIPAL_VARIATION)
+	{
+		value = principal_variation_search(thread, alpha_value, beta_value, search_level).value;
+	}
+	else if (thread->position.player_to_move == COMPUTER_PLAYER)
+	{
+		value = max_value(thread, alpha_value, beta_value, search_level).value;
+	}
+	else
+	{
+		value = -min_value(thread, -beta_value, -alpha_value, search_level).value;
+	}
+	thread->search_depth_limit = saved_depth_limit;
+	return value;
+}
+
+/*Multi-ProbCut: the deep value of a node is about slope * shallow value + intercept, off by deviation on average.
+  When a null-window shallow search shows the deep value outside alpha_value..beta_value with the configured
+  confidence, the node is cut there. The cheaper check goes first. Values are the computer's, as in max_value*/
+bool probcut_cuts(Search_Thread* thread, int alpha_value, int beta_value, int search_level, int* cut_value)
+{
+	Reversi_Game* game = thread->game;
+	Search_Position* position = &thread->position;
+	int search_depth = thread->search_depth_limit - search_level;
+	int sign = position->player_to_move == COMPUTER_PLAYER ? 1 : -1;
+	int stage = get_probcut_stage(game, position->empty_count);
+	/*the window of the side to move*/
+	int lower_value = sign > 0 ? alpha_value : -beta_value;
+	int upper_value = sign > 0 ? beta_value : -alpha_value;
+
+	if (search_depth < MPC_MIN_DEPTH || search_depth > MPC_MAX_DEPTH)
+	{
+		return false;
+	}
+
+	for (int check = MPC_CHECKS_PER_DEPTH - 1; check >= 0 && !game->search_aborted; check--)
+	{
+		Probcut_Fit* fit = &game->probcut_fits[stage][search_depth][check];
+		int shallow_depth = get_probcut_shallow_depth(search_depth, check);
+		double margin;
+
+		if (!fit->calibrated || shallow_depth < 1)
+		{
+			continue;
+		}
+		margin = game->probcut_confidence * fit->deviation;
+		thread->statistics.probcut_tries++;
+
+		if (upper_value < VERY_POSITIVE_VALUE)
+		{
+			int bound = round_up((upper_value + margin - fit->intercept) / fit->slope);
+
+			if (search_probcut_shallow(thread, bound - 1, bound, search_level, shallow_depth) >= bound && !game->search_aborted)
+			{
+				thread->statistics.probcut_cuts++;
+				*cut_value = sign * upper_value;
+				return true;
+			}
+		}
+		if (lower_value > VERY_NEGATIVE_VALUE)
+		{
+			int bound = round_down((lower_value - margin - fit->intercept) / fit->slope);
+
+			if (search_probcut_shallow(thread, bound, bound + 1, search_level, shallow_depth) <= bound && !game->search_aborted)
+			{
+				thread->statistics.probcut_cuts++;
+				*cut_value = sign * lower_value;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/******************/
+/*ENDGAME SOLVER*/
+/******************/
+
+/*Final disk differential for the side to move; empty cells are not counted*/
+int get_final_score(Search_Position* position)
+{
+	int net_score = evaluate_search_position(position);
+
+	return position->player_to_move == COMPUTER_PLAYER ? net_score : -net_score;
+}
+
+/*Quadrant of the square, for the parity ordering*/
+int get_square_quadrant(Reversi_Game* game, int square_index)
+{
+	return (square_index / game->board_size >= game->board_size / 2) * 2 + (square_index % game->board_size >= game->board_size / 2);
+}
+
+/*Parity bits of the four quadrants: bit q is set when quadrant q has an odd number of empty cells*/
+int get_quadrant_parity(Search_Position* position)
+{
+	Reversi_Game* game = position->game;
+	int parity = ZERO;
+
+	if (position->use_bitboard)
+	{
+		uint64_t empty_disks = ~(position->bitboard.player_disks | position->bitboard.opponent_disks);
+		static const uint64_t quadrant_masks[4] = { 0x000000000F0F0F0FULL, 0x00000000F0F0F0F0ULL, 0x0F0F0F0F00000000ULL, 0xF0F0F0F000000000ULL };
+
+		for (int quadrant = 0; quadrant < 4; quadrant++)
+		{
+			parity |= (bitboard_count_disks(empty_disks & quadrant_masks[quadrant]) & 1) << quadrant;
+		}
+		return parity;
+	}
+	if (position->use_wide_bitboard)
+	{
+		for (int i = 0; i < game->wide_geometry.word_count; i++)
+		{
+			uint64_t empty_disks = game->wide_geometry.board_mask.words[i] & ~(position->wide_bitboard.player_disks.words[i] | position->wide_bitboard.opponent_disks.words[i]);
+
+			while (empty_disks != 0)
+			{
+				parity ^= 1 << get_square_quadrant(game, i * 64 + bitboard_pop_lowest_square(&empty_disks));
+			}
+		}
+		return parity;
+	}
+	for (int i = 0; i < game->board_size; i++)
+	{
+		for (int j = 0; j < game->board_size; j++)
+		{
+			if (position->cells[i][j].cell_disk_color == ' ')
+			{
+				parity ^= 1 << get_square_quadrant(game, i * game->board_size + j);
+			}
+		}
+	}
+	return parity;
+}
+
+/*Moves into odd quadrants first. Far from the end the moves that leave the opponent the fewest replies go first,
+  which settles the search fastest; parity then only breaks ties*/
+void order_endgame_moves(Search_Thread* thread, Move_List* valid_moves)
+{
+	Reversi_Game* game = thread->game;
+	Search_Position* position = &thread->position;
+	Move_Arena* arena = &thread->workspace.move_arena;
+	bool fastest_first = position->empty_count > ENDGAME_FASTEST_FIRST_EMPTIES;
+	int parity = get_quadrant_parity(position);
+	int* move_keys;
+
+	if (valid_moves->count < 2)
+	{
+		return;
+	}
+
+	move_keys = arena->moves + arena->top;
+	arena->top += valid_moves->count;
+
+	for (int i = 0; i < valid_moves->count; i++)
+	{
+		int square_index = valid_moves->moves[i];
+
+		move_keys[i] = (parity >> get_square_quadrant(game, square_index)) & 1 ? ZERO : 1;
+		if (fastest_first)
+		{
+			move_keys[i] += 2 * count_opponent_replies(position, square_index);
+		}
+	}
+
+	for (int i = 1; i < valid_moves->count; i++)
+	{
+		int square_index = valid_moves->moves[i];
+		int key = move_keys[i];
+		int j = i - 1;
+
+		while (j >= 0 && move_keys[j] > key)
+		{
+			valid_moves->moves[j + 1] = valid_moves->moves[j];
+			move_keys[j + 1] = move_keys[j];
+			j--;
+		}
+		valid_moves->moves[j + 1] = square_index;
+		move_keys[j + 1] = key;
+	}
+
+	arena->top -= valid_moves->count;
+}
+
+/*Last empty square: the side to move plays it if it can, else the opponent does, else the game ends*/
+int solve_last_empty(uint64_t player_disks, uint64_t opponent_disks, int square_index)
+{
+	uint64_t flips = bitboard_get_flips(player_disks, opponent_disks, square_index);
+
+	if (flips != 0)
+	{
+		return bitboard_count_disks(player_disks | flips) + 1 - bitboard_count_disks(opponent_disks ^ flips);
+	}
+	flips = bitboard_get_flips(opponent_disks, player_disks, square_index);
+	if (flips != 0)
+	{
+		return bitboard_count_disks(player_disks ^ flips) - bitboard_count_disks(opponent_disks | flips) - 1;
+	}
+	return bitboard_count_disks(player_disks) - bitboard_count_disks(opponent_disks);
+}
+
+/*Negamax over the last few empty squares of a bitboard, given in parity order, without move lists*/
+int solve_last_empties(Search_Thread* thread, uint64_t player_disks, uint64_t opponent_disks, int alpha_value, int beta_value, int* empty_squares, int empty_count, bool passed)
+{
+	int best_value = VERY_NEGATIVE_VALUE;
+	bool moved = false;
+
+	thread->statistics.nodes++;
+	if (empty_count == 1)
+	{
+		return solve_last_empty(player_disks, opponent_disks, empty_squares[0]);
+	}
+
+	for (int i = 0; i < empty_count && alpha_value < beta_value; i++)
+	{
+		int square_index = empty_squares[i];
+		uint64_t flips = bitboard_get_flips(player_disks, opponent_disks, square_index);
+		int value;
+
+		if (flips == 0)
+		{
+			continue;
+		}
+		moved = true;
+
+		/*the played square moves to the end of the list, out of the children's reach*/
+		empty_squares[i] = empty_squares[empty_count - 1];
+		empty_squares[empty_count - 1] = square_index;
+		value = -solve_last_empties(thread, opponent_disks ^ flips, player_disks | flips | (1ULL << square_index), -beta_value, -alpha_value, empty_squares, empty_count - 1, false);
+		empty_squares[empty_count - 1] = empty_squares[i];
+		empty_squares[i] = square_index;
+
+		best_value = max(best_value, value);
+		alpha_value = max(alpha_value, value);
+	}
+
+	if (!moved)
+	{
+		if (passed)
+		{
+			return bitboard_count_disks(player_disks) - bitboard_count_disks(opponent_disks);
+		}
+		return -solve_last_empties(thread, opponent_disks, player_disks, -beta_value, -alpha_value, empty_squares, empty_count, true);
+	}
+	return best_value;
+}
+
+/*Exact disk differential for the side to move within alpha_value..beta_value; outside the window it is a bound*/
+int solve_endgame(Search_Thread* thread, int alpha_value, int beta_value)
+{
+	Search_Position* position = &thread->position;
+	Move_Undo move_undo;
+	Move_List valid_moves;
+	int best_value = VERY_NEGATIVE_VALUE;
+
+	if (search_time_is_up(thread))
+	{
+		return alpha_value;
+	}
+
+	if (position->use_bitboard && position->empty_count <= ENDGAME_LAST_EMPTIES)
+	{
+		uint64_t empty_disks = ~(position->bitboard.player_disks | position->bitboard.opponent_disks);
+		int parity = get_quadrant_parity(position);
+		int empty_squares[ENDGAME_LAST_EMPTIES];
+		int empty_count = ZERO;
+
+		/*odd quadrants first*/
+		for (int pass = 0; pass < 2; pass++)
+		{
+			uint64_t remaining = empty_disks;
+
+			while (remaining != 0)
+			{
+				int square_index = bitboard_pop_lowest_square(&remaining);
+
+				if (((parity >> get_square_quadrant(position->game, square_index)) & 1) == (pass == 0))
+				{
+					empty_squares[empty_count++] = square_index;
+				}
+			}
+		}
+		if (empty_count == ZERO)
+		{
+			return get_final_score(position);
+		}
+		return solve_last_empties(thread, position->bitboard.player_disks, position->bitboard.opponent_disks, alpha_value, beta_value, empty_squares, empty_count, false);
+	}
+
+	valid_moves = get_search_moves(position);
+	if (no_valid_moves_exist(&valid_moves))
+	{
+		release_valid_moves(position->workspace, &valid_moves);
+		if (!opponent_has_moves(position))
+		{
+			return get_final_score(position);
+		}
+		pass_search_position(position);
+		best_value = -solve_endgame(thread, -beta_value, -alpha_value);
+		pass_search_position(position);
+		return best_value;
+	}
+
+	order_endgame_moves(thread, &valid_moves);
+
+	for (int i = 0; i < valid_moves.count; i++)
+	{
+		int value;
+
+		make_search_move(position, valid_moves.moves[i], &move_undo);
+		value = -solve_endgame(thread, -beta_value, -alpha_value);
+		unmake_search_move(position, &move_undo);
+
+		if (thread->game->search_aborted)
+		{
+			break;
+		}
+		best_value = max(best_value, value);
+		alpha_value = max(alpha_value, value);
+		if (alpha_value >= beta_value)
+		{
+			break;
+		}
+	}
+	release_valid_moves(position->workspace, &valid_moves);
+	return best_value;
+}
+
+/*Value of the position for the computer, solved to the end of the game and weighted like a finished game. In
+  win/loss/draw mode only the sign of the margin is searched, and a proven win or loss is worth more than any
+  heuristic value*/
+int solve_endgame_for_computer(Search_Thread* thread, int alpha_value, int beta_value)
+{
+	Reversi_Game* game = thread->game;
+	bool computer_to_move = thread->position.player_to_move == COMPUTER_PLAYER;
+	int disk_weight = get_final_disk_weight(&thread->position);
+	/*the widest margins that still decide the weighted window*/
+	int lower_disks = alpha_value >= ZERO ? alpha_value / disk_weight : -((disk_weight - 1 - alpha_value) / disk_weight);
+	int upper_disks = beta_value >= ZERO ? (beta_value + disk_weight - 1) / disk_weight : -(-beta_value / disk_weight);
+	int value;
+
+	thread->statistics.endgame_solves++;
+
+	if (game->endgame_mode == ENDGAME_WIN_LOSS_DRAW)
+	{
+		value = solve_endgame(thread, -1, 1);
+		value = value > ZERO ? game->board_size * game->board_size : (value < ZERO ? -game->board_size * game->board_size : ZERO);
+	}
+	else if (computer_to_move)
+	{
+		value = solve_endgame(thread, lower_disks, upper_disks);
+	}
+	else
+	{
+		value = solve_endgame(thread, -upper_disks, -lower_disks);
+	}
+	return (computer_to_move ? value : -value) * disk_weight;
+}
+
+/*Root search of the principal variation mode. After the first iteration the window is centered on the last
+  score and only widened, on the side that failed, when the score falls outside it*/
+Alpha_Beta_Return search_root_with_aspiration(Search_Thread* thread)
+{
+	Reversi_Game* game = thread->game;
+	int window = game->evaluation == EVALUATION_PATTERNS ? ASPIRATION_PATTERN_WINDOW
+		: game->evaluation == EVALUATION_MOBILITY ? ASPIRATION_MOBILITY_WINDOW : ASPIRATION_DISK_WINDOW;
+	int alpha_value = VERY_NEGATIVE_VALUE;
+	int beta_value = VERY_POSITIVE_VALUE;
+	Alpha_Beta_Return return_value;
+
+	if (thread->principal_value != INVALID_VALUE)
+	{
+		alpha_value = max(thread->principal_value - window, VERY_NEGATIVE_VALUE);
+		beta_value = min(thread->principal_value + window, VERY_POSITIVE_VALUE);
+	}
+
+	for (;;)
+	{
+		return_value = principal_variation_search(thread, alpha_value, beta_value, ZERO);
+		if (game->search_aborted)
+		{
+			return return_value;
+		}
+		if (return_value.value <= alpha_value && alpha_value > VERY_NEGATIVE_VALUE)
+		{
+			alpha_value = max(alpha_value - window, VERY_NEGATIVE_VALUE);
+		}
+		else if (return_value.value >= beta_value && beta_value < VERY_POSITIVE_VALUE)
+		{
+			beta_value = min(beta_value + window, VERY_POSITIVE_VALUE);
+		}
+		else
+		{
+			return return_value;
+		}
+		thread->statistics.aspiration_failures++;
+		window *= 2;
+	}
+}
+
+/*MTD(f): closes in on the root value with null-window calls of max_value. The first guess is the value of two
+  iterations back, since disk counts swing between odd and even depths. Each call proves a bound and the
+  transposition table keeps what earlier calls learned, so with a small range of values few calls are needed. The
+  move comes from the last call that failed high, the one proving the value*/
+Alpha_Beta_Return search_root_with_mtdf(Search_Thread* thread)
+{
+	Reversi_Game* game = thread->game;
+	int lower_bound = VERY_NEGATIVE_VALUE;
+	int upper_bound = VERY_POSITIVE_VALUE;
+	int guess = thread->earlier_principal_value != INVALID_VALUE ? thread->earlier_principal_value
+		: (thread->principal_value != INVALID_VALUE ? thread->principal_value : ZERO);
+	Alpha_Beta_Return return_value = { INVALID_VALUE, INVALID_VALUE, INVALID_VALUE };
+	Alpha_Beta_Return pass_value;
+
+	while (lower_bound < upper_bound)
+	{
+		int beta_value = guess == lower_bound ? guess + 1 : guess;
+
+		thread->statistics.mtdf_passes++;
+		pass_value = max_value(thread, beta_value - 1, beta_value, ZERO);
+		if (game->search_aborted)
+		{
+			return pass_value;
+		}
+		guess = pass_value.value;
+		if (guess < beta_value)
+		{
+			upper_bound = guess;
+		}
+		else
+		{
+			lower_bound = guess;
+			return_value = pass_value;
+		}
+		/*without a failed-high call the root has no proven move yet, take the best refuted one*/
+		if (return_value.row_index == INVALID_VALUE)
+		{
+			return_value.row_index = pass_value.row_index;
+			return_value.column_index = pass_value.column_index;
+		}
+	}
+	return_value.value = guess;
+	return return_value;
+}
+
+/*Searches the root to search_depth levels; the result is only meaningful when search_aborted is still false*/
+Alpha_Beta_Return search_to_depth(Search_Thread* thread, int search_depth)
+{
+	Reversi_Game* game = thread->game;
+	Alpha_Beta_Return return_value;
+
+	thread->search_depth_limit = search_depth;
+
+	if (game->search_algorithm == SEARCH_PRINCIPAL_VARIATION)
+	{
+		return_value = search_root_with_aspiration(thread);
+	}
+	else if (game->search_algorithm == SEARCH_MTDF)
+	{
+		return_value = search_root_with_mtdf(thread);
+	}
+	else
+	{
+		return_value = max_value(thread, VERY_NEGATIVE_VALUE, VERY_POSITIVE_VALUE, ZERO);
+	}
+	if (!game->search_aborted && return_value.row_index != INVALID_VALUE)
+	{
+		thread->principal_move = return_value.row_index * game->board_size + return_value.column_index;
+		thread->earlier_principal_value = thread->principal_value;
+		thread->principal_value = return_value.value;
+	}
+	return return_value;
+}
+
+/******************/
+/*THREADS*/
+/******************/
+
+bool start_thread(Thread_Handle* handle, Thread_Routine routine, void* argument)
+{
+#ifdef _WIN32
+	*handle = (HANDLE)_beginthreadex(NULL, 0, routine, argument, 0, NULL);
+	return *handle != 0;
+#else
+	return pthread_create(handle, NULL, routine, argument) == 0;
+#endif
+}
+
+void join_thread(Thread_Handle* handle)
+{
+#ifdef _WIN32
+	WaitForSingleObject(*handle, INFINITE);
+	CloseHandle(*handle);
+#else
+	pthread_join(*handle, NULL);
+#endif
+}
+
+void create_mutex(Mutex_Handle* mutex)
+{
+#ifdef _WIN32
+	InitializeCriticalSection(mutex);
+#else
+	pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+void delete_mutex(Mutex_Handle* mutex)
+{
+#ifdef _WIN32
+	DeleteCriticalSection(mutex);
+#else
+	pthread_mutex_destroy(mutex);
+#endif
+}
+
+void lock_mutex(Mutex_Handle* mutex)
+{
+#ifdef _WIN32
+	EnterCriticalSection(mutex);
+#else
+	pthread_mutex_lock(mutex);
+#endif
+}
+
+void unlock_mutex(Mutex_Handle* mutex)
+{
+#ifdef _WIN32
+	LeaveCriticalSection(mutex);
+#else
+	pthread_mutex_unlock(mutex);
+#endif
+}
+
+void create_condition(Condition_Handle* condition)
+{
+#ifdef _WIN32
+	InitializeConditionVariable(condition);
+#else
+	pthread_cond_init(condition, NULL);
+#endif
+}
+
+void delete_condition(Condition_Handle* condition)
+{
+#ifdef _WIN32
+	(void)condition;
+#else
+	pthread_cond_destroy(condition);
+#endif
+}
+
+/*Releases the locked mutex until the condition is signalled, then locks it again. Wake-ups can be spurious,
+  so the caller checks its condition in a loop*/
+void wait_condition(Condition_Handle* condition, Mutex_Handle* mutex)
+{
+#ifdef _WIN32
+	SleepConditionVariableCS(condition, mutex, INFINITE);
+#else
+	pthread_cond_wait(condition, mutex);
+#endif
+}
+
+void signal_all_condition(Condition_Handle* condition)
+{
+#ifdef _WIN32
+	WakeAllConditionVariable(condition);
+#else
+	pthread_cond_broadcast(condition);
+#endif
+}
+
+/******************/
+/*MAPPED FILES*/
+/******************/
+
+/*Maps the whole file read-only and returns its first byte, or NULL. The pages are only read in when touched*/
+void* map_file(const char* path, size_t* mapped_size)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	HANDLE mapping;
+	LARGE_INTEGER file_size;
+	void* mapped_data = NULL;
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return NULL;
+	}
+	if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+	{
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping != NULL)
+		{
+			mapped_data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			*mapped_size = (size_t)file_size.QuadPart;
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+	return mapped_data;
+#else
+	int file = open(path, O_RDONLY);
+	struct stat file_status;
+	void* mapped_data = NULL;
+
+	if (file < 0)
+	{
+		return NULL;
+	}
+	if (fstat(file, &file_status) == 0 && file_status.st_size > 0)
+	{
+		mapped_data = mmap(NULL, (size_t)file_status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (mapped_data == MAP_FAILED)
+		{
+			mapped_data = NULL;
+		}
+		*mapped_size = (size_t)file_status.st_size;
+	}
+	close(file);
+	return mapped_data;
+#endif
+}
+
+void unmap_file(void* mapped_data, size_t mapped_size)
+{
+#ifdef _WIN32
+	(void)mapped_size;
+	UnmapViewOfFile(mapped_data);
+#else
+	munmap(mapped_data, mapped_size);
+#endif
+}
+
+/******************/
+/*PARALLEL SEARCH*/
+/******************/
+
+/*One search state per thread, allocated once per game like the workspace it holds. The main thread searches the
+  game board itself, every helper gets a private board to make and unmake moves on*/
+Search_Thread* create_search_threads(Reversi_Game* game)
+{
+	Search_Thread* threads = (Search_Thread*)calloc(game->search_thread_count, sizeof(Search_Thread));
+
+	for (int i = 0; i < game->search_thread_count; i++)
+	{
+		threads[i].game = game;
+		threads[i].workspace = create_search_workspace(game);
+		threads[i].cells = i == MAIN_SEARCH_THREAD ? NULL : create_the_board(game);
+		threads[i].thread_index = i;
+	}
+	return threads;
+}
+
+void delete_search_threads(Reversi_Game* game)
+{
+	Search_Thread* threads = game->search_threads;
+
+	for (int i = 0; i < game->search_thread_count; i++)
+	{
+		if (threads[i].cells != NULL)
+		{
+			delete_the_board(game, threads[i].cells);
+		}
+		delete_search_workspace(&threads[i].workspace);
+	}
+	free(threads);
+}
+
+/*Resets the thread for a new root; cells is the board it will search, the game board or its private copy*/
+void prepare_search_thread(Search_Thread* thread, Board_Cell** current_board)
+{
+	Reversi_Game* game = thread->game;
+	Board_Cell** cells = current_board;
+
+	if (thread->cells != NULL)
+	{
+		copy_the_board(game, thread->cells, current_board);
+		cells = thread->cells;
+	}
+	thread->position = create_search_position(game, cells, COMPUTER_PLAYER, &thread->workspace);
+	thread->search_depth_limit = INVALID_VALUE;
+	thread->principal_move = INVALID_VALUE;
+	thread->principal_value = INVALID_VALUE;
+	thread->earlier_principal_value = INVALID_VALUE;
+	memset(&thread->statistics, 0, sizeof(thread->statistics));
+	prepare_move_ordering(game, &thread->workspace);
+}
+
+/*Lazy SMP helper: deepens the same root as the main thread and shares what it learns only through the
+  transposition table. Every other helper starts one level deeper so the threads spread over different depths*/
+THREAD_FUNCTION run_helper_search(void* argument)
+{
+	Search_Thread* thread = (Search_Thread*)argument;
+	Reversi_Game* game = thread->game;
+
+	for (int search_depth = 1 + thread->thread_index % 2; search_depth <= game->game_level && !game->search_aborted; search_depth++)
+	{
+		search_to_depth(thread, search_depth);
+	}
+	THREAD_RETURN;
+}
+
+
+/******************/
+/*SEARCH STATISTICS*/
+/******************/
+
+void add_search_statistics(Search_Statistics* total, Search_Statistics* part)
+{
+	total->nodes += part->nodes;
+	total->leaf_evaluations += part->leaf_evaluations;
+	total->interior_nodes += part->interior_nodes;
+	total->moves_searched += part->moves_searched;
+	for (int i = 0; i < CUTOFF_INDEX_SLOTS; i++)
+	{
+		total->cutoffs[i] += part->cutoffs[i];
+	}
+	total->hash_probes += part->hash_probes;
+	total->hash_hits += part->hash_hits;
+	total->hash_cutoffs += part->hash_cutoffs;
+	total->endgame_solves += part->endgame_solves;
+	total->researches += part->researches;
+	total->aspiration_failures += part->aspiration_failures;
+	total->mtdf_passes += part->mtdf_passes;
+	total->probcut_tries += part->probcut_tries;
+	total->probcut_cuts += part->probcut_cuts;
+}
+
+void record_depth_report(Reversi_Game* game, int depth, long long start_time)
+{
+	Depth_Report* report = &game->depth_reports[game->depth_report_count++];
+
+	report->depth = depth;
+	report->time = get_time_in_milliseconds() - start_time;
+	report->nodes = game->search_threads[MAIN_SEARCH_THREAD].statistics.nodes;
+}
+
+/*The b for which b^depth equals the nodes of the last finished iteration of the main thread*/
+double get_effective_branching_factor(Reversi_Game* game)
+{
+	Depth_Report* last_report;
+	double iteration_nodes;
+	double low = 1.0;
+	double high;
+
+	if (game->depth_report_count == ZERO)
+	{
+		return 0.0;
+	}
+	last_report = &game->depth_reports[game->depth_report_count - 1];
+	iteration_nodes = (double)last_report->nodes;
+	if (game->depth_report_count > 1)
+	{
+		iteration_nodes -= (double)game->depth_reports[game->depth_report_count - 2].nodes;
+	}
+	high = iteration_nodes > 1.0 ? iteration_nodes : 1.0;
+
+	for (int step = 0; step < 64; step++)
+	{
+		double middle = (low + high) / 2;
+		double power = 1.0;
+
+		for (int i = 0; i < last_report->depth && power <= iteration_nodes; i++)
+		{
+			power *= middle;
+		}
+		if (power > iteration_nodes)
+		{
+			high = middle;
+		}
+		else
+		{
+			low = middle;
+		}
+	}
+	return low;
+}
+
+/*Counters shared by the per-move and the per-game records, as JSON members*/
+void write_statistics_members(FILE* stats_file, Search_Statistics* statistics, long long search_time)
+{
+	fprintf(stats_file, "\"time_ms\":%lld,\"nodes\":%llu,\"nodes_per_second\":%.0f,\"leaf_evaluations\":%llu,\"interior_nodes\":%llu,"
+		"\"moves_per_interior_node\":%.3f,\"cutoffs_by_move_index\":[",
+		search_time, statistics->nodes, statistics->nodes * 1000.0 / (search_time > 0 ? search_time : 1), statistics->leaf_evaluations,
+		statistics->interior_nodes, statistics->interior_nodes > 0 ? (double)statistics->moves_searched / statistics->interior_nodes : 0.0);
+	for (int i = 0; i < CUTOFF_INDEX_SLOTS; i++)
+	{
+		fprintf(stats_file, i == 0 ? "%llu" : ",%llu", statistics->cutoffs[i]);
+	}
+	fprintf(stats_file, "],\"hash_probes\":%llu,\"hash_hits\":%llu,\"hash_cutoffs\":%llu,\"endgame_solves\":%llu,\"researches\":%llu,\"aspiration_failures\":%llu,\"mtdf_passes\":%llu,\"probcut_tries\":%llu,\"probcut_cuts\":%llu",
+		statistics->hash_probes, statistics->hash_hits, statistics->hash_cutoffs, statistics->endgame_solves, statistics->researches, statistics->aspiration_failures,
+		statistics->mtdf_passes, statistics->probcut_tries, statistics->probcut_cuts);
+}
+
+/*One JSON line for the search that just chose move*/
+void write_search_statistics(Reversi_Game* game, Cell_Coordinates move)
+{
+	FILE* stats_file = game->stats_file;
+
+	if (stats_file == NULL)
+	{
+		return;
+	}
+	fprintf(stats_file, "{\"record\":\"move\",\"computer\":\"%s\",\"move_number\":%d,", game->computer_disk_color, game->computer_moves_searched);
+	if (move.row_index == INVALID_VALUE)
+	{
+		fprintf(stats_file, "\"move\":\"pass\",");
+	}
+	else
+	{
+		fprintf(stats_file, "\"move\":\"%c%d\",", move.column_index + 'a', move.row_index + 1);
+	}
+	fprintf(stats_file, "\"depth\":%d,\"effective_branching_factor\":%.3f,", game->last_search_depth, get_effective_branching_factor(game));
+	write_statistics_members(stats_file, &game->last_search_statistics, game->last_search_time);
+
+	fprintf(stats_file, ",\"depths\":[");
+	for (int i = 0; i < game->depth_report_count; i++)
+	{
+		fprintf(stats_file, "%s{\"depth\":%d,\"time_ms\":%lld,\"nodes\":%llu}", i == 0 ? "" : ",",
+			game->depth_reports[i].depth, game->depth_reports[i].time, game->depth_reports[i].nodes);
+	}
+	fprintf(stats_file, "]}\n");
+	fflush(stats_file);
+}
+
+/*One JSON line with the totals of every search of the game*/
+void write_game_statistics(Reversi_Game* game)
+{
+	fprintf(game->stats_file, "{\"record\":\"game\",\"computer\":\"%s\",\"computer_moves\":%d,\"black_disks\":%d,\"white_disks\":%d,",
+		game->computer_disk_color, game->computer_moves_searched, game->current_black_disks, game->current_white_disks);
+	write_statistics_members(game->stats_file, &game->game_statistics, game->game_search_time);
+	fprintf(game->stats_file, "}\n");
+	fflush(game->stats_file);
+}
+
+/******************/
+/*SEARCH DRIVER*/
+/******************/
+
+/*Milliseconds the computer may spend on this move, or NO_TIME_LIMIT. A game clock is spread over the
+  moves the computer still has to make, roughly half of the empty cells*/
+long long get_move_time_budget(Reversi_Game* game)
+{
+	long long time_budget = game->move_time_limit;
+
+	if (game->game_clock_remaining != NO_TIME_LIMIT)
+	{
+		int computer_moves_left = (game->board_size * game->board_size - game->current_black_disks - game->current_white_disks) / 2 + 1;
+
+		if (time_budget == NO_TIME_LIMIT || game->game_clock_remaining / computer_moves_left < time_budget)
+		{
+			time_budget = game->game_clock_remaining / computer_moves_left + 1;
+		}
+	}
+	return time_budget;
+}
+
+/*With one thread and no time budget the root is searched once to game_level. Otherwise the main thread deepens
+  one level at a time and returns the move of the deepest level that finished; level 1 always finishes so a move
+  is found. Helper threads search the same root alongside it until the main thread is done*/
+Cell_Coordinates alpha_beta_search(Reversi_Game* game, Board_Cell** current_board, int search_level)
+{
+	Cell_Coordinates selected_move_coordinate;
+	Alpha_Beta_Return return_value;
+	Alpha_Beta_Return iteration_value;
+	Search_Thread* main_thread = &game->search_threads[MAIN_SEARCH_THREAD];
+	int helpers_started = ZERO;
+	bool solve_from_root;
+	long long time_budget = get_move_time_budget(game);
+	long long start_time = get_time_in_milliseconds();
+
+	game->search_aborted = false;
+	game->search_deadline = NO_TIME_LIMIT;
+	prepare_search_thread(main_thread, current_board);
+	/*every child of the root is solved, so one level settles the move and helpers have nothing to add*/
+	solve_from_root = game->endgame_empties > ZERO && main_thread->position.empty_count <= game->endgame_empties + 1;
+
+	for (int i = 1; i < game->search_thread_count && !solve_from_root; i++)
+	{
+		prepare_search_thread(&game->search_threads[i], current_board);
+		if (!start_thread(&game->search_threads[i].handle, run_helper_search, &game->search_threads[i]))
+		{
+			break;
+		}
+		helpers_started++;
+	}
+
+	game->depth_report_count = ZERO;
+
+	if (solve_from_root)
+	{
+		return_value = search_to_depth(main_thread, 1);
+		game->last_search_depth = main_thread->position.empty_count;
+		record_depth_report(game, game->last_search_depth, start_time);
+	}
+	else if (time_budget == NO_TIME_LIMIT && helpers_started == ZERO)
+	{
+		return_value = search_to_depth(main_thread, game->game_level - search_level);
+		game->last_search_depth = game->game_level - search_level;
+		record_depth_report(game, game->last_search_depth, start_time);
+	}
+	else
+	{
+		return_value = search_to_depth(main_thread, 1);
+		game->last_search_depth = 1;
+		record_depth_report(game, 1, start_time);
+		if (time_budget != NO_TIME_LIMIT)
+		{
+			game->search_deadline = start_time + time_budget;
+		}
+
+		for (int search_depth = 2; search_depth <= game->game_level - search_level; search_depth++)
+		{
+			/*the next level usually costs more than everything searched so far*/
+			if (time_budget != NO_TIME_LIMIT && (get_time_in_milliseconds() - start_time) * 2 > time_budget)
+			{
+				break;
+			}
+
+			iteration_value = search_to_depth(main_thread, search_depth);
+			if (game->search_aborted)
+			{
+				break;
+			}
+			return_value = iteration_value;
+			game->last_search_depth = search_depth;
+			record_depth_report(game, search_depth, start_time);
+		}
+	}
+
+	/*stops the helpers at their next node*/
+	game->search_aborted = true;
+	game->last_search_statistics = main_thread->statistics;
+	for (int i = 1; i <= helpers_started; i++)
+	{
+		join_thread(&game->search_threads[i].handle);
+		add_search_statistics(&game->last_search_statistics, &game->search_threads[i].statistics);
+	}
+	game->last_search_time = get_time_in_milliseconds() - start_time;
+	add_search_statistics(&game->game_statistics, &game->last_search_statistics);
+	game->game_search_time += game->last_search_time;
+	game->computer_moves_searched++;
+
+	if (game->game_clock_remaining != NO_TIME_LIMIT)
+	{
+		game->game_clock_remaining -= get_time_in_milliseconds() - start_time;
+		if (game->game_clock_remaining < 1)
+		{
+			game->game_clock_remaining = 1;
+		}
+	}
+
+	game->last_search_value = return_value.value;
+	selected_move_coordinate.row_index = return_value.row_index;
+	selected_move_coordinate.column_index = return_value.column_index;
+	write_search_statistics(game, selected_move_coordinate);
+
+	return selected_move_coordinate;
+}
+
+/******************/
+/*PONDERING*/
+/******************/
+
+/*Deepens the position after the user's reply by one more iteration, from where the last one for this reply stopped*/
+void ponder_reply(Search_Thread* thread, int reply, int search_depth)
+{
+	Reversi_Game* game = thread->game;
+	Ponder_Result* result = &game->ponder_results[reply];
+	Alpha_Beta_Return return_value;
+	bool solve_from_root;
+
+	if (game->search_aborted || result->depth >= search_depth)
+	{
+		return;
+	}
+	copy_the_board(game, game->ponder_board, game->board);
+	apply_move_in_place(game, game->ponder_board, get_coordinates_from_square(game, reply), USER_PLAYER, NULL);
+	prepare_search_thread(thread, game->ponder_board);
+	if (result->depth > ZERO)
+	{
+		thread->principal_move = result->principal_move;
+		thread->principal_value = result->principal_value;
+		thread->earlier_principal_value = result->earlier_principal_value;
+	}
+	/*as in alpha_beta_search, one level settles a root whose children are all solved*/
+	solve_from_root = game->endgame_empties > ZERO && thread->position.empty_count <= game->endgame_empties + 1;
+
+	return_value = search_to_depth(thread, solve_from_root ? 1 : search_depth);
+	add_search_statistics(&result->statistics, &thread->statistics);
+	if (!game->search_aborted && return_value.row_index != INVALID_VALUE)
+	{
+		result->depth = solve_from_root ? game->game_level : search_depth;
+		result->principal_move = thread->principal_move;
+		result->principal_value = thread->principal_value;
+		result->earlier_principal_value = thread->earlier_principal_value;
+	}
+}
+
+/*Searches every reply of the user while the main thread waits for input. The reply the computer's own search
+  expected, its hash move, goes to the full level first; the others are then deepened together, one level at a time.
+  All of it also lands in the transposition table, which the search after the actual reply finds*/
+THREAD_FUNCTION run_ponder_search(void* argument)
+{
+	Search_Thread* thread = (Search_Thread*)argument;
+	Reversi_Game* game = thread->game;
+	Move_List valid_moves = get_valid_moves(game, &thread->workspace, game->board, USER_PLAYER);
+	Transposition_Data entry;
+	int reply_count = valid_moves.count;
+
+	for (int i = 0; i < reply_count; i++)
+	{
+		game->ponder_replies[i] = valid_moves.moves[i];
+	}
+	release_valid_moves(&thread->workspace, &valid_moves);
+
+	if (probe_transposition_table(&game->transposition_table, get_board_hash_key(game, game->board, get_character_from_color(game->user_disk_color)), &entry))
+	{
+		for (int i = 1; i < reply_count; i++)
+		{
+			if (game->ponder_replies[i] == entry.best_move)
+			{
+				game->ponder_replies[i] = game->ponder_replies[0];
+				game->ponder_replies[0] = entry.best_move;
+			}
+		}
+	}
+
+	for (int search_depth = 1; search_depth <= game->game_level && reply_count > ZERO && !game->search_aborted; search_depth++)
+	{
+		ponder_reply(thread, game->ponder_replies[0], search_depth);
+	}
+	for (int search_depth = 1; search_depth <= game->game_level && !game->search_aborted; search_depth++)
+	{
+		for (int i = 1; i < reply_count; i++)
+		{
+			ponder_reply(thread, game->ponder_replies[i], search_depth);
+		}
+	}
+	THREAD_RETURN;
+}
+
+/*Starts pondering on the user's turn, unless it already runs*/
+void start_pondering(Reversi_Game* game)
+{
+	if (!game->pondering_enabled || game->pondering || game->current_turn != USER_TURN)
+	{
+		return;
+	}
+	memset(game->ponder_results, 0, game->board_size * game->board_size * sizeof(Ponder_Result));
+	game->ponder_reply = INVALID_VALUE;
+	game->search_aborted = false;
+	game->search_deadline = NO_TIME_LIMIT;
+	game->pondering = start_thread(&game->ponder_thread.handle, run_ponder_search, &game->ponder_thread);
+}
+
+/*Stops the ponder thread at its next node and waits for it; its results stay until pondering starts again*/
+void stop_pondering(Reversi_Game* game)
+{
+	if (!game->pondering)
+	{
+		return;
+	}
+	game->search_aborted = true;
+	join_thread(&game->ponder_thread.handle);
+	game->pondering = false;
+}
+
+/*The move found by pondering the reply the user played, when it was searched to the full level, or an invalid
+  move. Its search is reported like one made on the computer's own time, which it took none of*/
+Cell_Coordinates get_pondered_move(Reversi_Game* game)
+{
+	Cell_Coordinates pondered_move = { INVALID_VALUE, INVALID_VALUE, ' ', INVALID_VALUE };
+	Ponder_Result* result;
+
+	if (!game->pondering_enabled || game->ponder_reply == INVALID_VALUE)
+	{
+		return pondered_move;
+	}
+	result = &game->ponder_results[game->ponder_reply];
+	game->ponder_reply = INVALID_VALUE;
+	if (result->depth < game->game_level)
+	{
+		return pondered_move;
+	}
+
+	pondered_move = get_coordinates_from_square(game, result->principal_move);
+	game->last_search_statistics = result->statistics;
+	game->last_search_depth = result->depth;
+	game->last_search_value = result->principal_value;
+	game->last_search_time = ZERO;
+	game->depth_report_count = ZERO;
+	add_search_statistics(&game->game_statistics, &result->statistics);
+	game->computer_moves_searched++;
+	game->pondered_moves++;
+	write_search_statistics(game, pondered_move);
+
+	return pondered_move;
+}
+
+/******************/
+/*OPENING BOOK*/
+/******************/
+
+void close_opening_book(Opening_Book* book)
+{
+	if (book->mapped_data != NULL)
+	{
+		unmap_file(book->mapped_data, book->mapped_size);
+	}
+	book->mapped_data = NULL;
+	book->entries = NULL;
+	book->entry_count = 0;
+}
+
+/*Maps the book at path for a game of board_size; a missing or foreign file leaves the book empty*/
+Opening_Book open_opening_book(const char* path, int board_size)
+{
+	Opening_Book book = { NULL, 0, NULL, 0 };
+	const Book_Header* header;
+
+	book.mapped_data = map_file(path, &book.mapped_size);
+	if (book.mapped_data == NULL)
+	{
+		printf("Cannot open the opening book %s\n", path);
+		return book;
+	}
+
+	header = (const Book_Header*)book.mapped_data;
+	if (book.mapped_size < sizeof(Book_Header) || memcmp(header->magic, BOOK_MAGIC, sizeof(header->magic)) != 0
+		|| header->version != BOOK_VERSION || book.mapped_size != sizeof(Book_Header) + header->entry_count * sizeof(Book_Entry))
+	{
+		printf("%s is not an opening book\n", path);
+		close_opening_book(&book);
+		return book;
+	}
+	if ((int)header->board_size != board_size)
+	{
+		printf("The opening book %s is for %ux%u boards\n", path, header->board_size, header->board_size);
+		close_opening_book(&book);
+		return book;
+	}
+
+	book.entries = (const Book_Entry*)(header + 1);
+	book.entry_count = header->entry_count;
+	return book;
+}
+
+/*Binary search of the sorted entries*/
+const Book_Entry* find_book_entry(Opening_Book* book, uint64_t hash_key)
+{
+	size_t low = 0;
+	size_t high = book->entry_count;
+
+	while (low < high)
+	{
+		size_t middle = low + (high - low) / 2;
+
+		if (book->entries[middle].hash_key < hash_key)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	return low < book->entry_count && book->entries[low].hash_key == hash_key ? &book->entries[low] : NULL;
+}
+
+/*The book move of the computer on current_board, or INVALID_VALUE coordinates when the position is not in the book.
+  The move is checked against the legal moves, so a hash collision cannot play an illegal one*/
+Cell_Coordinates get_book_move(Reversi_Game* game, Board_Cell** current_board)
+{
+	Cell_Coordinates book_move = { INVALID_VALUE, INVALID_VALUE, ' ', INVALID_VALUE };
+	Search_Workspace* workspace = &game->search_threads[MAIN_SEARCH_THREAD].workspace;
+	const Book_Entry* entry;
+	Move_List valid_moves;
+
+	if (game->opening_book.entry_count == 0)
+	{
+		return book_move;
+	}
+	entry = find_book_entry(&game->opening_book, get_board_hash_key(game, current_board, get_character_from_color(game->computer_disk_color)));
+	if (entry == NULL)
+	{
+		return book_move;
+	}
+
+	valid_moves = get_valid_moves(game, workspace, current_board, COMPUTER_PLAYER);
+	for (int i = 0; i < valid_moves.count; i++)
+	{
+		if (valid_moves.moves[i] == entry->best_move)
+		{
+			book_move = get_coordinates_from_square(game, entry->best_move);
+		}
+	}
+	release_valid_moves(workspace, &valid_moves);
+	return book_move;
+}
+
+/******************/
+/*POSITION ENCODING*/
+/******************/
+
+/*A position as one byte for the side to move (0 black, 1 white) and the cells row by row at 2 bits each
+  (0 empty, 1 black, 2 white), four to a byte from the low bits up. The bulk functions below work on cells as text,
+  B, W and anything else for empty, eight cells per 64-bit word*/
+int get_encoded_position_length(int board_size)
+{
+	return 1 + (board_size * board_size + 3) / 4;
+}
+
+/*Eight bytes as a little-endian word, whatever the machine's byte order; compilers turn it into one load*/
+uint64_t load_cell_word(const char* cells)
+{
+	uint64_t word = 0;
+
+	for (int i = 0; i < 8; i++)
+	{
+		word |= (uint64_t)(unsigned char)cells[i] << (8 * i);
+	}
+	return word;
+}
+
+/*0x80 in every byte of word that equals the byte of pattern, 0 elsewhere*/
+uint64_t get_equal_byte_mask(uint64_t word, uint64_t pattern)
+{
+	uint64_t difference = word ^ pattern;
+
+	return ~(((difference & 0x7F7F7F7F7F7F7F7FULL) + 0x7F7F7F7F7F7F7F7FULL) | difference | 0x7F7F7F7F7F7F7F7FULL);
+}
+
+/*Packs cell_count cells of text into 2-bit codes*/
+void encode_cells(const char* cells, int cell_count, unsigned char* packed_cells)
+{
+	int i = 0;
+
+	for (; i + 8 <= cell_count; i += 8)
+	{
+		uint64_t word = load_cell_word(cells + i);
+		/*one code per byte, then the bytes folded together two, four and eight at a time*/
+		uint64_t codes = (get_equal_byte_mask(word, 0x4242424242424242ULL) >> 7) | (get_equal_byte_mask(word, 0x5757575757575757ULL) >> 6);
+
+		codes = (codes | (codes >> 6)) & 0x000F000F000F000FULL;
+		codes = (codes | (codes >> 12)) & 0x000000FF000000FFULL;
+		codes = (codes | (codes >> 24)) & 0xFFFFULL;
+		packed_cells[i / 4] = (unsigned char)codes;
+		packed_cells[i / 4 + 1] = (unsigned char)(codes >> 8);
+	}
+	if (i < cell_count)
+	{
+		memset(packed_cells + i / 4, 0, (cell_count - i + 3) / 4);
+	}
+	for (; i < cell_count; i++)
+	{
+		int code = cells[i] == 'B' ? POSITION_CODE_BLACK : cells[i] == 'W' ? POSITION_CODE_WHITE : POSITION_CODE_EMPTY;
+
+		packed_cells[i / 4] |= (unsigned char)(code << (2 * (i % 4)));
+	}
+}
+
+/*Unpacks cell_count 2-bit codes into B, W and - and ends the text. Returns false when a code is not a cell*/
+bool decode_cells(const unsigned char* packed_cells, int cell_count, char* cells)
+{
+	uint64_t invalid_codes = 0;
+	int i = 0;
+
+	for (; i + 8 <= cell_count; i += 8)
+	{
+		/*the same folds as encode_cells, undone*/
+		uint64_t codes = packed_cells[i / 4] | (uint64_t)packed_cells[i / 4 + 1] << 8;
+		uint64_t text;
+
+		codes = (codes | (codes << 24)) & 0x000000FF000000FFULL;
+		codes = (codes | (codes << 12)) & 0x000F000F000F000FULL;
+		codes = (codes | (codes << 6)) & 0x0303030303030303ULL;
+		invalid_codes |= codes & (codes >> 1);
+		text = 0x2D2D2D2D2D2D2D2DULL + (codes & 0x0101010101010101ULL) * ('B' - '-') + ((codes >> 1) & 0x0101010101010101ULL) * ('W' - '-');
+		for (int j = 0; j < 8; j++)
+		{
+			cells[i + j] = (char)(text >> (8 * j));
+		}
+	}
+	for (; i < cell_count; i++)
+	{
+		int code = (packed_cells[i / 4] >> (2 * (i % 4))) & 3;
+
+		invalid_codes |= code == 3;
+		cells[i] = code == POSITION_CODE_BLACK ? 'B' : code == POSITION_CODE_WHITE ? 'W' : '-';
+	}
+	cells[cell_count] = '\0';
+	return (invalid_codes & 0x0101010101010101ULL) == 0;
+}
+
+/*count positions of cell_count cells each, stored one after the other, with their sides to move*/
+void encode_positions(const char* cells, const int* color_indexes, int position_count, int cell_count, unsigned char* encoded)
+{
+	int encoded_length = 1 + (cell_count + 3) / 4;
+
+	for (int i = 0; i < position_count; i++)
+	{
+		encoded[i * encoded_length] = (unsigned char)color_indexes[i];
+		encode_cells(cells + (size_t)i * cell_count, cell_count, encoded + (size_t)i * encoded_length + 1);
+	}
+}
+
+/*The reverse of encode_positions; cells gets cell_count + 1 characters per position, each text ended. Returns the
+  number of positions read before the first that is not one*/
+int decode_positions(const unsigned char* encoded, int position_count, int cell_count, char* cells, int* color_indexes)
+{
+	int encoded_length = 1 + (cell_count + 3) / 4;
+
+	for (int i = 0; i < position_count; i++)
+	{
+		color_indexes[i] = encoded[(size_t)i * encoded_length];
+		if (color_indexes[i] > WHITE_INDEX || !decode_cells(encoded + (size_t)i * encoded_length + 1, cell_count, cells + (size_t)i * (cell_count + 1)))
+		{
+			return i;
+		}
+	}
+	return position_count;
+}
+
+/*The text form "<cells> black|white" of an encoded position, for debugging and for the batch input*/
+void format_position_text(const char* cells, int color_index, char* text)
+{
+	sprintf(text, "%s %s", cells, color_index == BLACK_INDEX ? "black" : "white");
+}
+
+/*Splits text in the form above: cells, room for cell_count cells and the terminator, gets the first word and the
+  side to move is returned. INVALID_VALUE when the first word is longer than cell_count or the second word names no
+  side. Only the first letter of the side counts*/
+int parse_position_text(const char* text, char* cells, int cell_count)
+{
+	size_t cells_length;
+	const char* side;
+
+	text += strspn(text, " \t");
+	cells_length = strcspn(text, " \t\r\n");
+	if (cells_length > (size_t)cell_count)
+	{
+		cells[0] = '\0';
+		return INVALID_VALUE;
+	}
+	memcpy(cells, text, cells_length);
+	cells[cells_length] = '\0';
+	side = text + cells_length;
+	side += strspn(side, " \t");
+	if (tolower(side[0]) == 'b')
+	{
+		return BLACK_INDEX;
+	}
+	return tolower(side[0]) == 'w' ? WHITE_INDEX : INVALID_VALUE;
+}
+
+/*A square as its column letters and row number, d3 or j10. Columns past z go on as aa, ab and so on*/
+void format_move_text(Reversi_Game* game, int square_index, char* text)
+{
+	int column_index = square_index % game->board_size;
+
+	if (column_index >= 26)
+	{
+		*text++ = (char)('a' + column_index / 26 - 1);
+	}
+	sprintf(text, "%c%d", 'a' + column_index % 26, square_index / game->board_size + 1);
+}
+
+/*Reads a square in the form above, letters in either case, into coordinates. Returns false when text is not one or
+  names a cell off the board*/
+bool parse_move_text(Reversi_Game* game, const char* text, Cell_Coordinates* coordinates)
+{
+	int column_index = -1;
+	int row_number = ZERO;
+	int letter_count = ZERO;
+	int digit_count = ZERO;
+
+	for (; isalpha((unsigned char)text[letter_count]) && letter_count < 2; letter_count++)
+	{
+		column_index = (column_index + 1) * 26 + tolower((unsigned char)text[letter_count]) - 'a';
+	}
+	for (; isdigit((unsigned char)text[letter_count + digit_count]) && digit_count < 3; digit_count++)
+	{
+		row_number = row_number * 10 + text[letter_count + digit_count] - '0';
+	}
+	if (letter_count == ZERO || digit_count == ZERO || isalnum((unsigned char)text[letter_count + digit_count]))
+	{
+		return false;
+	}
+	*coordinates = get_coordinates_from_square(game, ZERO);
+	coordinates->row_index = row_number - 1;
+	coordinates->column_index = column_index;
+	coordinates->board_row = row_number;
+	coordinates->board_column = (char)tolower((unsigned char)text[letter_count - 1]);
+	return is_cell_within_board_boundary(game, *coordinates);
+}
+
+
+/*Loads a row-major string of B, W and - (or .) onto the board*/
+bool load_board_position(Reversi_Game* game, Board_Cell** current_board, char* cells)
+{
+	if ((int)strlen(cells) != game->board_size * game->board_size)
+	{
+		return false;
+	}
+	for (int i = 0; i < game->board_size * game->board_size; i++)
+	{
+		char cell = (char)toupper(cells[i]);
+
+		if (cell != 'B' && cell != 'W' && cell != '-' && cell != '.')
+		{
+			return false;
+		}
+		current_board[i / game->board_size][i % game->board_size].cell_disk_color = (cell == 'B' || cell == 'W') ? cell : ' ';
+	}
+	return true;
+}
+
+void encode_position(Reversi_Game* game, Board_Cell** current_board, int color_index, unsigned char* encoded)
+{
+	char cells[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+
+	for (int i = 0; i < game->board_size * game->board_size; i++)
+	{
+		cells[i] = current_board[i / game->board_size][i % game->board_size].cell_disk_color;
+	}
+	encoded[0] = (unsigned char)color_index;
+	encode_cells(cells, game->board_size * game->board_size, encoded + 1);
+}
+
+/******************/
+/*GAME RECORDS*/
+/******************/
+
+/*A record is the magic, a version and board_size bytes, then every move from the initial position, black first.
+  A move is its square + 1, or 0 for a pass, in one byte while the board has fewer than 255 cells and as a
+  varint (7 bits a byte, low bits first, the high bit set on all but the last byte) on larger boards*/
+bool write_record_header(FILE* record_file, int board_size)
+{
+	unsigned char header[6] = { RECORD_MAGIC[0], RECORD_MAGIC[1], RECORD_MAGIC[2], RECORD_MAGIC[3], RECORD_VERSION, (unsigned char)board_size };
+
+	return fwrite(header, 1, sizeof(header), record_file) == sizeof(header);
+}
+
+/*Returns the board size, or INVALID_VALUE when the file is not a record*/
+int read_record_header(FILE* record_file)
+{
+	unsigned char header[6];
+
+	if (fread(header, 1, sizeof(header), record_file) != sizeof(header) || memcmp(header, RECORD_MAGIC, 4) != 0 || header[4] != RECORD_VERSION
+		|| header[5] < MIN_BOARD_SIZE || header[5] > MAX_BOARD_SIZE)
+	{
+		return INVALID_VALUE;
+	}
+	return header[5];
+}
+
+/*square_index is INVALID_VALUE for a pass*/
+void write_record_move(FILE* record_file, int board_size, int square_index)
+{
+	unsigned int move_code = square_index == INVALID_VALUE ? RECORD_PASS_CODE : (unsigned int)square_index + 1;
+
+	if (board_size * board_size < 255)
+	{
+		fputc((int)move_code, record_file);
+		return;
+	}
+	while (move_code >= 0x80)
+	{
+		fputc((int)(move_code & 0x7F) | 0x80, record_file);
+		move_code >>= 7;
+	}
+	fputc((int)move_code, record_file);
+}
+
+/*The next move's square, INVALID_VALUE for a pass, or EOF at the end of the record*/
+int read_record_move(FILE* record_file, int board_size)
+{
+	int move_code = ZERO;
+	int next_byte = fgetc(record_file);
+
+	if (next_byte == EOF)
+	{
+		return EOF;
+	}
+	if (board_size * board_size < 255)
+	{
+		move_code = next_byte;
+	}
+	else
+	{
+		for (int shift = 0; ; shift += 7)
+		{
+			move_code |= (next_byte & 0x7F) << shift;
+			if ((next_byte & 0x80) == 0 || shift > 14)
+			{
+				break;
+			}
+			if ((next_byte = fgetc(record_file)) == EOF)
+			{
+				return EOF;
+			}
+		}
+	}
+	return move_code == RECORD_PASS_CODE ? INVALID_VALUE : move_code - 1;
+}
+
+/*Appends a move of player_type to the record of the game, when it keeps one. The command loop has no pass: a side
+  that moves twice in a row had the other side pass in between*/
+void record_game_move(Reversi_Game* game, Cell_Coordinates move, int player_type)
+{
+	int color_index = get_color_index(get_character_from_color(player_type == USER_PLAYER ? game->user_disk_color : game->computer_disk_color));
+
+	if (game->record_file == NULL)
+	{
+		return;
+	}
+	if (color_index != game->record_color_to_move)
+	{
+		write_record_move(game->record_file, game->board_size, INVALID_VALUE);
+	}
+	write_record_move(game->record_file, game->board_size, move.row_index * game->board_size + move.column_index);
+	game->record_color_to_move = 1 - color_index;
+	fflush(game->record_file);
+}
+
+/******************/
+/*GAME LIFECYCLE*/
+/******************/
+
+/*A game with the default options and nothing allocated yet; set its size, level, colors and options, then
+  call start_reversi_game*/
+Reversi_Game* create_reversi_game()
+{
+	Reversi_Game* game = (Reversi_Game*)calloc(1, sizeof(Reversi_Game));
+
+	game->board_size = INVALID_VALUE;
+	game->game_level = INVALID_VALUE;
+	game->current_turn = INVALID_VALUE;
+	game->current_black_disks = INITIAL_BLACK_DISKS;
+	game->current_white_disks = INITIAL_WHITE_DISKS;
+	game->search_thread_count = 1;
+	game->transposition_table_megabytes = DEFAULT_HASH_MEGABYTES;
+	game->move_time_limit = NO_TIME_LIMIT;
+	game->game_clock_remaining = NO_TIME_LIMIT;
+	game->search_deadline = NO_TIME_LIMIT;
+	game->move_ordering_enabled = true;
+	game->mobility_sort_depth = DEFAULT_MOBILITY_SORT_DEPTH;
+	game->endgame_mode = ENDGAME_EXACT;
+	game->evaluation = EVALUATION_DISKS;
+	game->search_algorithm = SEARCH_ALPHA_BETA;
+	game->probcut_confidence = DEFAULT_PROBCUT_CONFIDENCE;
+	game->ponder_reply = INVALID_VALUE;
+	game->simd_enabled = true;
+	game->leaf_batching_enabled = true;
+
+	return game;
+}
+
+/*Allocates the board, the search threads and the transposition table once the settings are final*/
+void start_reversi_game(Reversi_Game* game)
+{
+	game->board = create_the_board(game);
+	select_wide_bitboard_kernels(game);
+	select_leaf_batch_kernel(game);
+	game->search_threads = create_search_threads(game);
+	game->transposition_table = create_transposition_table(game->transposition_table_megabytes);
+	game->depth_reports = (Depth_Report*)malloc((game->game_level + 1) * sizeof(Depth_Report));
+
+	if (game->evaluation == EVALUATION_PATTERNS)
+	{
+		game->patterns = create_pattern_evaluator(game->board_size);
+	}
+	if (game->book_path[0] != '\0')
+	{
+		game->opening_book = open_opening_book(game->book_path, game->board_size);
+	}
+	if (game->probcut_path[0] != '\0')
+	{
+		game->probcut_enabled = load_probcut_fits(game, game->probcut_path);
+	}
+	if (game->pondering_enabled)
+	{
+		game->ponder_thread.game = game;
+		game->ponder_thread.workspace = create_search_workspace(game);
+		game->ponder_thread.cells = create_the_board(game);
+		game->ponder_thread.thread_index = game->search_thread_count;
+		game->ponder_board = create_the_board(game);
+		game->ponder_replies = (int*)malloc(game->board_size * game->board_size * sizeof(int));
+		game->ponder_results = (Ponder_Result*)calloc(game->board_size * game->board_size, sizeof(Ponder_Result));
+	}
+	if (game->record_path[0] != '\0')
+	{
+		game->record_file = fopen(game->record_path, "wb");
+		if (game->record_file == NULL || !write_record_header(game->record_file, game->board_size))
+		{
+			printf("Cannot write the game record %s\n", game->record_path);
+		}
+	}
+	if (game->stats_path[0] != '\0')
+	{
+		game->stats_file = fopen(game->stats_path, "a");
+		if (game->stats_file == NULL)
+		{
+			printf("Cannot open %s, no statistics will be written\n", game->stats_path);
+		}
+	}
+}
+
+/*Empties the transposition table and the move history of every search thread, so that the next search does not
+  depend on the ones before it*/
+void clear_search_memory(Reversi_Game* game)
+{
+	clear_transposition_table(&game->transposition_table);
+	for (int i = 0; i < game->search_thread_count; i++)
+	{
+		memset(game->search_threads[i].workspace.history_scores[0], 0, game->board_size * game->board_size * sizeof(int));
+		memset(game->search_threads[i].workspace.history_scores[1], 0, game->board_size * game->board_size * sizeof(int));
+	}
+}
+
+/*Frees the game, started or not, after writing its statistics record*/
+void delete_reversi_game(Reversi_Game* game)
+{
+	stop_pondering(game);
+	if (game->stats_file != NULL)
+	{
+		write_game_statistics(game);
+		fclose(game->stats_file);
+	}
+	if (game->record_file != NULL)
+	{
+		fclose(game->record_file);
+	}
+	free(game->depth_reports);
+	close_opening_book(&game->opening_book);
+	if (game->patterns != NULL)
+	{
+		delete_pattern_evaluator(game->patterns);
+	}
+	if (game->search_threads != NULL)
+	{
+		delete_transposition_table(&game->transposition_table);
+		delete_search_threads(game);
+	}
+	if (game->ponder_board != NULL)
+	{
+		delete_the_board(game, game->ponder_thread.cells);
+		delete_search_workspace(&game->ponder_thread.workspace);
+		delete_the_board(game, game->ponder_board);
+		free(game->ponder_replies);
+		free(game->ponder_results);
+	}
+	if (game->board != NULL)
+	{
+		delete_the_board(game, game->board);
+	}
+	free(game->current_input_command);
+	free(game);
+}
+
+Cell_Coordinates play_computer_move(Reversi_Game* game)
+{
+	Cell_Coordinates computer_move_coodinates;
+
+	computer_move_coodinates = get_book_move(game, game->board);
+	if (computer_move_coodinates.row_index == INVALID_VALUE)
+	{
+		computer_move_coodinates = get_pondered_move(game);
+	}
+	if (computer_move_coodinates.row_index == INVALID_VALUE)
+	{
+		computer_move_coodinates = alpha_beta_search(game, game->board, ZERO);
+	}
+	else
+	{
+		/*showstats reports an empty search for a book move*/
+		memset(&game->last_search_statistics, 0, sizeof(game->last_search_statistics));
+		game->last_search_depth = ZERO;
+		game->last_search_time = ZERO;
+		game->depth_report_count = ZERO;
+	}
+
+	if (computer_move_coodinates.row_index == INVALID_VALUE && computer_move_coodinates.column_index == INVALID_VALUE)
+	{
+
+	}
+	else
+	{
+		register_move(game, game->board, computer_move_coodinates, COMPUTER_PLAYER);
+		record_game_move(game, computer_move_coodinates, COMPUTER_PLAYER);
+	}
+
+	computer_move_coodinates.board_row = computer_move_coodinates.row_index + 1;
+	computer_move_coodinates.board_column = computer_move_coodinates.column_index + 'a';
+
+	return computer_move_coodinates;
+}
+
+Game_Status play_game(Reversi_Game* game)
+{
+	Cell_Coordinates current_move = { INVALID_VALUE, INVALID_VALUE,' ', INVALID_VALUE };
+
+	
+	if (game->current_input_command == NULL)
+	{
+		game->current_input_command = malloc(MENU_INPUT_LENGTH * sizeof(char));
+	}
+	/*runs until the user plays, across showstate, showstats and invalid input*/
+	start_pondering(game);
+
+	printf("\n>");
+	fgets(game->current_input_command,MENU_INPUT_LENGTH,stdin);
+	if(strcmp(game->current_input_command,"\n") == 0)
+	{
+		fgets(game->current_input_command,MENU_INPUT_LENGTH,stdin);
+	}
+	game->current_input_command[strcspn(game->current_input_command, "\n")] = 0;
+
+	if (strcmp(game->current_input_command, "quit") == 0)
+	{
+		stop_pondering(game);
+		return QUIT;
+	}
+
+	if (strcmp(game->current_input_command, "showstats") == 0)
+	{
+		Search_Statistics* statistics = &game->last_search_statistics;
+
+		printf("Nodes searched: %llu\n", statistics->nodes);
+		printf("Search depth: %d\n", game->last_search_depth);
+		printf("Search time: %lld ms\n", game->last_search_time);
+		printf("Leaf evaluations: %llu\n", statistics->leaf_evaluations);
+		printf("Effective branching factor: %.2f\n", get_effective_branching_factor(game));
+		printf("Cutoffs by move index:");
+		for (int i = 0; i < CUTOFF_INDEX_SLOTS; i++)
+		{
+			printf(" %llu", statistics->cutoffs[i]);
+		}
+		printf("\n");
+		printf("Hash probes: %llu, hits: %llu, cutoffs: %llu\n", statistics->hash_probes, statistics->hash_hits, statistics->hash_cutoffs);
+		printf("Endgame solves: %llu\n", statistics->endgame_solves);
+		printf("Re-searches: %llu, aspiration failures: %llu, MTD(f) passes: %llu\n", statistics->researches, statistics->aspiration_failures, statistics->mtdf_passes);
+		printf("ProbCut searches: %llu, cuts: %llu\n", statistics->probcut_tries, statistics->probcut_cuts);
+		if (game->pondering_enabled)
+		{
+			printf("Moves answered from pondering: %d of %d\n", game->pondered_moves, game->computer_moves_searched);
+		}
+		for (int i = 0; i < game->depth_report_count; i++)
+		{
+			printf("Depth %d done after %lld ms, %llu nodes\n", game->depth_reports[i].depth, game->depth_reports[i].time, game->depth_reports[i].nodes);
+		}
+		return CONTINUE;
+	}
+
+	if (strcmp(game->current_input_command, "showstate") == 0)
+	{
+		if (game->current_turn == COMPUTER_TURN)
+		{
+			display_the_board(game, game->board, NULL, false); 
+			printf("%s player (computer) plays now\n", game->computer_disk_color);
+			printf("White: %d - Black: %d\n", game->current_white_disks, game->current_black_disks);
+		}
+		else
+		{
+			Move_List allowed_moves = get_valid_moves(game, &game->search_threads[MAIN_SEARCH_THREAD].workspace, game->board, USER_PLAYER);
+			
+			display_the_board(game, game->board, &allowed_moves, true);
+			release_valid_moves(&game->search_threads[MAIN_SEARCH_THREAD].workspace, &allowed_moves);
+
+			printf("%s player (human) plays now\n", game->user_disk_color);
+			printf("White: %d - Black: %d\n", game->current_white_disks, game->current_black_disks);
+		}
+	}
+
+	else if (strcmp(game->current_input_command, "cont") == 0)
+	{
+		stop_pondering(game);
+		current_move = play_computer_move(game);
+		Move_List allowed_moves = get_valid_moves(game, &game->search_threads[MAIN_SEARCH_THREAD].workspace, game->board, USER_PLAYER);
+
+		display_the_board(game, game->board, &allowed_moves, true); 
+		release_valid_moves(&game->search_threads[MAIN_SEARCH_THREAD].workspace, &allowed_moves);
+
+
+		if (current_move.row_index == INVALID_VALUE && current_move.column_index == INVALID_VALUE)
+		{
+			printf("No move possible for computer\n");
+
+			Move_List allowed_moves = get_valid_moves(game, &game->search_threads[MAIN_SEARCH_THREAD].workspace, game->board, USER_PLAYER);
+
+			if (no_valid_moves_exist(&allowed_moves))
+			{
+				release_valid_moves(&game->search_threads[MAIN_SEARCH_THREAD].workspace, &allowed_moves);
+				printf("White: %d - Black: %d\n", game->current_white_disks, game->current_black_disks);
+				printf("END OF GAME\n");
+				return COMPLETE;
+			}
+			release_valid_moves(&game->search_threads[MAIN_SEARCH_THREAD].workspace, &allowed_moves);
+		}
+		else
+		{
+			char move_text[PROTOCOL_MOVE_LENGTH];
+
+			format_move_text(game, current_move.row_index * game->board_size + current_move.column_index, move_text);
+			printf("Move played: %s\n", move_text);
+		}
+		printf("%s player (human) plays now\n", game->user_disk_color);
+		printf("White: %d - Black: %d\n", game->current_white_disks, game->current_black_disks);
+		switch_the_turn(game);
+	}
+	else //play <move>
+	{
+		const char s[2] = " ";
+		char* token;
+		char move_text[PROTOCOL_MOVE_LENGTH];
+
+		token = strtok(game->current_input_command, s);
+		token = strtok(NULL, s);
+
+		//check validity of the move
+		Move_List allowed_moves = get_valid_moves(game, &game->search_threads[MAIN_SEARCH_THREAD].workspace, game->board, USER_PLAYER);
+		if (token == NULL || !parse_move_text(game, token, &current_move) || !is_move_allowed(game, &allowed_moves, current_move))
+		{
+			//invalid input, retry
+			printf("Invalid input\n");
+			release_valid_moves(&game->search_threads[MAIN_SEARCH_THREAD].workspace, &allowed_moves);
+			return CONTINUE;
+		}
+		release_valid_moves(&game->search_threads[MAIN_SEARCH_THREAD].workspace, &allowed_moves);
+		stop_pondering(game);
+		game->ponder_reply = current_move.row_index * game->board_size + current_move.column_index;
+		register_move(game, game->board, current_move, USER_PLAYER);
+		record_game_move(game, current_move, USER_PLAYER);
+		
+		display_the_board(game, game->board, NULL, false);
+		format_move_text(game, current_move.row_index * game->board_size + current_move.column_index, move_text);
+		printf("Move played: %s\n", move_text);
+		printf("%s player (computer) plays now\n", game->computer_disk_color);
+		printf("White: %d - Black: %d\n", game->current_white_disks, game->current_black_disks);
+		switch_the_turn(game);
+	}
+	return CONTINUE;
+}
+
+/*Optional settings after the level on the newgame line, given as name=value*/
+void parse_game_option(Reversi_Game* game, char* option)
+{
+	char* value = strchr(option, '=');
+
+	if (value == NULL)
+	{
+		printf("Ignoring option %s\n", option);
+		return;
+	}
+	*value++ = '\0';
+
+	if (strcmp(option, "hash") == 0)
+	{
+		game->transposition_table_megabytes = max(atoi(value), ZERO);
+	}
+	else if (strcmp(option, "threads") == 0)
+	{
+		game->search_thread_count = min(max(atoi(value), 1), MAX_SEARCH_THREADS);
+	}
+	else if (strcmp(option, "stats") == 0)
+	{
+		strncpy(game->stats_path, value, MENU_INPUT_LENGTH - 1);
+	}
+	else if (strcmp(option, "simd") == 0)
+	{
+		game->simd_enabled = strcmp(value, "off") != 0;
+	}
+	else if (strcmp(option, "leafbatch") == 0)
+	{
+		game->leaf_batching_enabled = strcmp(value, "off") != 0;
+	}
+	else if (strcmp(option, "order") == 0)
+	{
+		game->move_ordering_enabled = strcmp(value, "off") != 0;
+	}
+	else if (strcmp(option, "mobilitysort") == 0)
+	{
+		game->mobility_sort_depth = max(atoi(value), ZERO);
+	}
+	else if (strcmp(option, "book") == 0)
+	{
+		strncpy(game->book_path, value, MENU_INPUT_LENGTH - 1);
+	}
+	else if (strcmp(option, "probcut") == 0)
+	{
+		strncpy(game->probcut_path, value, MENU_INPUT_LENGTH - 1);
+	}
+	else if (strcmp(option, "probcutconfidence") == 0)
+	{
+		game->probcut_confidence = atof(value) > 0 ? atof(value) : 0;
+	}
+	else if (strcmp(option, "record") == 0)
+	{
+		strncpy(game->record_path, value, MENU_INPUT_LENGTH - 1);
+	}
+	else if (strcmp(option, "ponder") == 0)
+	{
+		game->pondering_enabled = strcmp(value, "on") == 0;
+	}
+	else if (strcmp(option, "search") == 0)
+	{
+		if (strcmp(value, "pvs") == 0)
+		{
+			game->search_algorithm = SEARCH_PRINCIPAL_VARIATION;
+		}
+		else if (strcmp(value, "mtdf") == 0)
+		{
+			game->search_algorithm = SEARCH_MTDF;
+		}
+		else
+		{
+			game->search_algorithm = SEARCH_ALPHA_BETA;
+		}
+	}
+	else if (strcmp(option, "eval") == 0)
+	{
+		game->evaluation = get_evaluation_from_name(value);
+	}
+	else if (strcmp(option, "endgame") == 0)
+	{
+		game->endgame_empties = max(atoi(value), ZERO);
+	}
+	else if (strcmp(option, "solve") == 0)
+	{
+		game->endgame_mode = strcmp(value, "wld") == 0 ? ENDGAME_WIN_LOSS_DRAW : ENDGAME_EXACT;
+	}
+	else if (strcmp(option, "time") == 0)
+	{
+		game->move_time_limit = max(atoi(value), 1);
+	}
+	else if (strcmp(option, "clock") == 0)
+	{
+		game->game_clock_remaining = atoll(value) > 0 ? atoll(value) : 1;
+	}
+	else
+	{
+		printf("Ignoring option %s\n", option);
+	}
+}
+
+/******************/
+/*SELF-PLAY ARENA*/
+/******************/
+
+/*Games between engine A and engine B, shared by the worker threads. Results are counted for engine A*/
+typedef struct
+{
+	Reversi_Game* engine_settings[2];			/*A and B; never started, only their options are copied*/
+	int board_size;
+	int game_count;
+	int random_plies;							/*random moves at the start of every game*/
+	uint64_t random_seed;
+	Mutex_Handle lock;							/*guards everything below*/
+	int next_game;
+	int wins;
+	int draws;
+	int losses;
+	long long disc_margin;
+	unsigned long long nodes_searched;
+}Self_Play_Arena;
+
+bool is_valid_level(int game_level)
+{
+	return game_level >= 1 && game_level != INVALID_VALUE;
+}
+
+/*A new game with the options of the settings game, playing color_index as the computer*/
+Reversi_Game* create_self_play_engine(Reversi_Game* settings, int board_size, int color_index)
+{
+	Reversi_Game* game = create_reversi_game();
+
+	*game = *settings;
+	game->board_size = board_size;
+	/*engines of one run all share the settings, but a record is of one interactive game*/
+	game->record_path[0] = '\0';
+	strcpy(game->computer_disk_color, color_index == BLACK_INDEX ? "Black" : "White");
+	strcpy(game->user_disk_color, color_index == BLACK_INDEX ? "White" : "Black");
+	start_reversi_game(game);
+
+	return game;
+}
+
+/*Readies an engine of create_self_play_engine for a new game as color_index, as a new engine would start it: the
+  initial board, the clock of the settings, no counters, and a transposition table and move history that remember
+  nothing of the last game. A statistics file first gets the record of the game played before, if any*/
+void restart_self_play_engine(Reversi_Game* game, Reversi_Game* settings, int color_index, bool game_played)
+{
+	Board_Cell** initial_board = create_the_board(game);
+
+	if (game_played && game->stats_file != NULL)
+	{
+		write_game_statistics(game);
+	}
+	strcpy(game->computer_disk_color, color_index == BLACK_INDEX ? "Black" : "White");
+	strcpy(game->user_disk_color, color_index == BLACK_INDEX ? "White" : "Black");
+	copy_the_board(game, game->board, initial_board);
+	delete_the_board(game, initial_board);
+	update_disks_count(game, game->board);
+
+	game->game_clock_remaining = settings->game_clock_remaining;
+	game->computer_moves_searched = ZERO;
+	game->game_search_time = ZERO;
+	memset(&game->game_statistics, 0, sizeof(game->game_statistics));
+	clear_search_memory(game);
+}
+
+/*Plays one game between worker_engines, A and B, and returns engine A's disc margin. A has black in even games and
+  white in odd ones; both games of a pair start from the same random opening*/
+int play_self_play_game(Self_Play_Arena* arena, Reversi_Game** worker_engines, bool engines_played, int game_index, unsigned long long* nodes_searched)
+{
+	Reversi_Game* engines[2];					/*by color*/
+	int engine_a_color = game_index % 2 == 0 ? BLACK_INDEX : WHITE_INDEX;
+	int color_to_move = BLACK_INDEX;
+	int passes = ZERO;
+	uint64_t random_state = arena->random_seed ^ ((uint64_t)(game_index / 2) * 0x9E3779B97F4A7C15ULL);
+
+	restart_self_play_engine(worker_engines[0], arena->engine_settings[0], engine_a_color, engines_played);
+	restart_self_play_engine(worker_engines[1], arena->engine_settings[1], 1 - engine_a_color, engines_played);
+	engines[engine_a_color] = worker_engines[0];
+	engines[1 - engine_a_color] = worker_engines[1];
+
+	for (int ply = 0; passes < 2; ply++)
+	{
+		Reversi_Game* mover = engines[color_to_move];
+		Reversi_Game* waiter = engines[1 - color_to_move];
+		Move_List valid_moves = get_valid_moves(mover, &mover->search_threads[MAIN_SEARCH_THREAD].workspace, mover->board, COMPUTER_PLAYER);
+		Cell_Coordinates move;
+
+		if (no_valid_moves_exist(&valid_moves))
+		{
+			release_valid_moves(&mover->search_threads[MAIN_SEARCH_THREAD].workspace, &valid_moves);
+			passes++;
+			color_to_move = 1 - color_to_move;
+			continue;
+		}
+		passes = ZERO;
+
+		if (ply < arena->random_plies)
+		{
+			move = get_coordinates_from_square(mover, valid_moves.moves[get_next_random_key(&random_state) % valid_moves.count]);
+			release_valid_moves(&mover->search_threads[MAIN_SEARCH_THREAD].workspace, &valid_moves);
+		}
+		else
+		{
+			release_valid_moves(&mover->search_threads[MAIN_SEARCH_THREAD].workspace, &valid_moves);
+			move = get_book_move(mover, mover->board);
+			if (move.row_index == INVALID_VALUE)
+			{
+				move = alpha_beta_search(mover, mover->board, ZERO);
+				*nodes_searched += mover->last_search_statistics.nodes;
+			}
+		}
+		register_move(mover, mover->board, move, COMPUTER_PLAYER);
+		register_move(waiter, waiter->board, move, USER_PLAYER);
+		color_to_move = 1 - color_to_move;
+	}
+
+	return get_the_score(engines[engine_a_color], COMPUTER_PLAYER);
+}
+
+/*Plays games until none are left, with one pair of engines made at its first game and restarted for the next*/
+THREAD_FUNCTION run_self_play_worker(void* argument)
+{
+	Self_Play_Arena* arena = (Self_Play_Arena*)argument;
+	Reversi_Game* engines[2] = { NULL, NULL };	/*A and B*/
+	bool engines_played = false;
+
+	for (;;)
+	{
+		int game_index;
+		int disc_margin;
+		unsigned long long nodes_searched = ZERO;
+
+		lock_mutex(&arena->lock);
+		game_index = arena->next_game++;
+		unlock_mutex(&arena->lock);
+
+		if (game_index >= arena->game_count)
+		{
+			break;
+		}
+		if (engines[0] == NULL)
+		{
+			engines[0] = create_self_play_engine(arena->engine_settings[0], arena->board_size, BLACK_INDEX);
+			engines[1] = create_self_play_engine(arena->engine_settings[1], arena->board_size, WHITE_INDEX);
+		}
+		disc_margin = play_self_play_game(arena, engines, engines_played, game_index, &nodes_searched);
+		engines_played = true;
+
+		lock_mutex(&arena->lock);
+		if (disc_margin > ZERO)
+		{
+			arena->wins++;
+		}
+		else if (disc_margin < ZERO)
+		{
+			arena->losses++;
+		}
+		else
+		{
+			arena->draws++;
+		}
+		arena->disc_margin += disc_margin;
+		arena->nodes_searched += nodes_searched;
+		unlock_mutex(&arena->lock);
+	}
+
+	if (engines[0] != NULL)
+	{
+		delete_reversi_game(engines[0]);
+		delete_reversi_game(engines[1]);
+	}
+	THREAD_RETURN;
+}
+
+/*Sets an option of engine A ("a.name=value"), engine B ("b.name=value") or both ("name=value")*/
+void parse_engine_option(Self_Play_Arena* arena, char* option)
+{
+	int first_engine = 0;
+	int last_engine = 1;
+
+	if ((option[0] == 'a' || option[0] == 'b') && option[1] == '.')
+	{
+		first_engine = last_engine = option[0] - 'a';
+		option += 2;
+	}
+	for (int i = first_engine; i <= last_engine; i++)
+	{
+		char engine_option[MENU_INPUT_LENGTH];
+
+		/*parse_game_option cuts the option at '=', so every engine gets its own copy*/
+		strcpy(engine_option, option);
+		if (strncmp(engine_option, "level=", 6) == 0)
+		{
+			arena->engine_settings[i]->game_level = atoi(engine_option + 6);
+		}
+		else
+		{
+			parse_game_option(arena->engine_settings[i], engine_option);
+		}
+	}
+}
+
+/*selfplay <size> <games> [option=value ...]: plays the games over a pool of workers and prints the results of
+  engine A against engine B*/
+int run_self_play(char* menu_arguments)
+{
+	const char s[2] = " ";
+	char* token;
+	int worker_count = 1;
+	int workers_started = ZERO;
+	long long start_time;
+	long long elapsed_time;
+	double elapsed_seconds;
+	Thread_Handle* workers;
+	Self_Play_Arena arena;
+
+	memset(&arena, 0, sizeof(arena));
+	arena.engine_settings[0] = create_reversi_game();
+	arena.engine_settings[1] = create_reversi_game();
+	arena.board_size = INVALID_VALUE;
+	arena.random_seed = ZOBRIST_SEED;
+
+	token = strtok(menu_arguments, s);
+	for (int menu_item = 1; token != NULL; menu_item++)
+	{
+		if (menu_item == 1)
+		{
+			arena.board_size = atoi(token);
+		}
+		else if (menu_item == 2)
+		{
+			arena.game_count = atoi(token);
+		}
+		else if (strncmp(token, "workers=", 8) == 0)
+		{
+			worker_count = min(max(atoi(token + 8), 1), MAX_SEARCH_THREADS);
+		}
+		else if (strncmp(token, "random=", 7) == 0)
+		{
+			arena.random_plies = max(atoi(token + 7), ZERO);
+		}
+		else if (strncmp(token, "seed=", 5) == 0)
+		{
+			arena.random_seed = strtoull(token + 5, NULL, 10);
+		}
+		else
+		{
+			parse_engine_option(&arena, token);
+		}
+		token = strtok(NULL, s);
+	}
+
+	if (arena.board_size < MIN_BOARD_SIZE || arena.board_size > MAX_BOARD_SIZE || arena.board_size % 2 != 0 || arena.game_count < 1
+		|| !is_valid_level(arena.engine_settings[0]->game_level) || !is_valid_level(arena.engine_settings[1]->game_level))
+	{
+		printf("Invalid self-play: the size must be even and between %d and %d, at least 1 game, and a level=<n> for both engines\n", MIN_BOARD_SIZE, MAX_BOARD_SIZE);
+		delete_reversi_game(arena.engine_settings[0]);
+		delete_reversi_game(arena.engine_settings[1]);
+		return 1;
+	}
+
+	initialize_zobrist_keys();
+	create_mutex(&arena.lock);
+	workers = (Thread_Handle*)malloc(worker_count * sizeof(Thread_Handle));
+	start_time = get_time_in_milliseconds();
+
+	for (int i = 0; i < worker_count; i++)
+	{
+		if (!start_thread(&workers[i], run_self_play_worker, &arena))
+		{
+			break;
+		}
+		workers_started++;
+	}
+	if (workers_started == ZERO)
+	{
+		run_self_play_worker(&arena);
+	}
+	for (int i = 0; i < workers_started; i++)
+	{
+		join_thread(&workers[i]);
+	}
+	elapsed_time = get_time_in_milliseconds() - start_time;
+	elapsed_seconds = (elapsed_time > 0 ? elapsed_time : 1) / 1000.0;
+
+	printf("Self-play: %d games on %dx%d, %d workers\n", arena.game_count, arena.board_size, arena.board_size, max(workers_started, 1));
+	printf("Engine A: %d wins, %d draws, %d losses\n", arena.wins, arena.draws, arena.losses);
+	printf("Average disc margin (A - B): %+.2f\n", (double)arena.disc_margin / arena.game_count);
+	printf("Games/sec: %.2f\n", arena.game_count / elapsed_seconds);
+	printf("Nodes/sec: %.0f\n", arena.nodes_searched / elapsed_seconds);
+
+	free(workers);
+	delete_mutex(&arena.lock);
+	delete_reversi_game(arena.engine_settings[0]);
+	delete_reversi_game(arena.engine_settings[1]);
+
+	return 0;
+}
+
+/******************/
+/*PERFT*/
+/******************/
+
+/*Leaf positions depth moves below position. A side without moves passes, which counts as a move, and a finished
+  game is a leaf wherever it ends. With bulk_count the last level is counted from the move list instead of played*/
+unsigned long long perft(Search_Position* position, int depth, bool bulk_count)
+{
+	Move_Undo move_undo;
+	Move_List valid_moves;
+	unsigned long long leaf_count = ZERO;
+
+	if (depth == ZERO)
+	{
+		return 1;
+	}
+
+	valid_moves = get_search_moves(position);
+	if (no_valid_moves_exist(&valid_moves))
+	{
+		release_valid_moves(position->workspace, &valid_moves);
+		if (!opponent_has_moves(position))
+		{
+			return 1;
+		}
+		pass_search_position(position);
+		leaf_count = perft(position, depth - 1, bulk_count);
+		pass_search_position(position);
+		return leaf_count;
+	}
+
+	if (bulk_count && depth == 1)
+	{
+		leaf_count = valid_moves.count;
+	}
+	else
+	{
+		for (int i = 0; i < valid_moves.count; i++)
+		{
+			make_search_move(position, valid_moves.moves[i], &move_undo);
+			leaf_count += perft(position, depth - 1, bulk_count);
+			unmake_search_move(position, &move_undo);
+		}
+	}
+	release_valid_moves(position->workspace, &valid_moves);
+	return leaf_count;
+}
+
+/*Walks position and reference, a copy on the generic board without a frontier, move by move and compares their moves, disks and hash
+  keys at every node. Prints the first difference and returns false there*/
+bool verify_move_generation(Search_Position* position, Search_Position* reference, int depth, unsigned long long* node_count)
+{
+	Move_Undo move_undo;
+	Move_Undo reference_undo;
+	Move_List valid_moves = get_search_moves(position);
+	Move_List reference_moves = get_search_moves(reference);
+	bool matches = true;
+
+	(*node_count)++;
+
+	if (valid_moves.count != reference_moves.count
+		|| memcmp(valid_moves.moves, reference_moves.moves, valid_moves.count * sizeof(int)) != 0
+		|| evaluate_search_position(position) != evaluate_search_position(reference)
+		|| position->hash_key != reference->hash_key)
+	{
+		printf("Move generation differs from the reference after node %llu: %d moves against %d\n", *node_count, valid_moves.count, reference_moves.count);
+		matches = false;
+	}
+	else if (depth > ZERO && no_valid_moves_exist(&valid_moves))
+	{
+		if (opponent_has_moves(position))
+		{
+			pass_search_position(position);
+			pass_search_position(reference);
+			matches = verify_move_generation(position, reference, depth - 1, node_count);
+			pass_search_position(reference);
+			pass_search_position(position);
+		}
+	}
+	else if (depth > ZERO)
+	{
+		for (int i = 0; i < valid_moves.count && matches; i++)
+		{
+			make_search_move(position, valid_moves.moves[i], &move_undo);
+			make_search_move(reference, reference_moves.moves[i], &reference_undo);
+			matches = verify_move_generation(position, reference, depth - 1, node_count);
+			unmake_search_move(reference, &reference_undo);
+			unmake_search_move(position, &move_undo);
+		}
+	}
+	release_valid_moves(reference->workspace, &reference_moves);
+	release_valid_moves(position->workspace, &valid_moves);
+	return matches;
+}
+
+/*perft <size> <depth> [option=value ...]: counts the leaves at every depth up to depth and how fast they were
+  reached. verify=on also checks the move generator used by the search against the generic one*/
+int run_perft(char* menu_arguments)
+{
+	const char s[2] = " ";
+	char* token;
+	char* position_cells = NULL;
+	bool bulk_count = false;
+	bool verify = false;
+	int player_to_move = COMPUTER_PLAYER;
+	int perft_depth = INVALID_VALUE;
+	Reversi_Game* game = create_reversi_game();
+	Search_Position position;
+
+	/*the computer plays black, so the player to move also tells the color*/
+	strcpy(game->computer_disk_color, "Black");
+	strcpy(game->user_disk_color, "White");
+	game->transposition_table_megabytes = ZERO;
+
+	token = strtok(menu_arguments, s);
+	for (int menu_item = 1; token != NULL; menu_item++)
+	{
+		if (menu_item == 1)
+		{
+			game->board_size = atoi(token);
+		}
+		else if (menu_item == 2)
+		{
+			perft_depth = atoi(token);
+		}
+		else if (strncmp(token, "bulk=", 5) == 0)
+		{
+			bulk_count = strcmp(token + 5, "on") == 0;
+		}
+		else if (strncmp(token, "verify=", 7) == 0)
+		{
+			verify = strcmp(token + 7, "on") == 0;
+		}
+		else if (strncmp(token, "position=", 9) == 0)
+		{
+			position_cells = token + 9;
+		}
+		else if (strncmp(token, "tomove=", 7) == 0)
+		{
+			player_to_move = strcmp(token + 7, "white") == 0 ? USER_PLAYER : COMPUTER_PLAYER;
+		}
+		else
+		{
+			printf("Ignoring option %s\n", token);
+		}
+		token = strtok(NULL, s);
+	}
+
+	if (game->board_size < MIN_BOARD_SIZE || game->board_size > MAX_BOARD_SIZE || game->board_size % 2 != 0 || !is_valid_level(perft_depth))
+	{
+		printf("Invalid perft: the size must be even and between %d and %d, the depth at least 1\n", MIN_BOARD_SIZE, MAX_BOARD_SIZE);
+		delete_reversi_game(game);
+		return 1;
+	}
+
+	/*the workspace holds one move list per level*/
+	game->game_level = perft_depth;
+	initialize_zobrist_keys();
+	start_reversi_game(game);
+
+	if (position_cells != NULL && !load_board_position(game, game->board, position_cells))
+	{
+		printf("Invalid position: give %d cells of B, W or -, row by row\n", game->board_size * game->board_size);
+		delete_reversi_game(game);
+		return 1;
+	}
+	update_disks_count(game, game->board);
+	position = create_search_position(game, game->board, player_to_move, &game->search_threads[MAIN_SEARCH_THREAD].workspace);
+
+	printf("Perft %dx%d, %s to move%s\n", game->board_size, game->board_size, player_to_move == COMPUTER_PLAYER ? "black" : "white", bulk_count ? ", bulk counting" : "");
+	for (int depth = 1; depth <= perft_depth; depth++)
+	{
+		long long start_time = get_time_in_milliseconds();
+		unsigned long long leaf_count = perft(&position, depth, bulk_count);
+		long long elapsed_time = get_time_in_milliseconds() - start_time;
+
+		printf("Depth %d: %llu leaves in %lld ms, %.0f leaves/sec\n", depth, leaf_count, elapsed_time, leaf_count * 1000.0 / (elapsed_time > 0 ? elapsed_time : 1));
+	}
+
+	if (verify)
+	{
+		Board_Cell** reference_board = create_the_board(game);
+		Search_Workspace reference_workspace = create_search_workspace(game);
+		Search_Position reference;
+		unsigned long long node_count = ZERO;
+
+		copy_the_board(game, reference_board, game->board);
+		reference = create_search_position(game, reference_board, player_to_move, &reference_workspace);
+		reference.use_bitboard = false;
+		reference.use_wide_bitboard = false;
+		reference.use_frontier = false;
+
+		if (verify_move_generation(&position, &reference, perft_depth, &node_count))
+		{
+			printf("Move generation matches the reference at all %llu nodes\n", node_count);
+		}
+		delete_search_workspace(&reference_workspace);
+		delete_the_board(game, reference_board);
+	}
+
+	delete_reversi_game(game);
+	return 0;
+}
+
+/******************/
+/*BOOK BUILDER*/
+/******************/
+
+/*Walks the opening tree twice at once: once with the engine as black and once as white. Where the engine is to
+  move only its own choice is followed, and where its opponent is to move every reply is, so the book answers
+  any opening the opponent picks without enumerating the whole tree*/
+typedef struct
+{
+	Reversi_Game* engines[2];					/*the engine playing black and the one playing white*/
+	int board_size;
+	int book_plies;
+	Book_Entry* entries;
+	size_t entry_count;
+	size_t entry_capacity;
+	uint64_t* visited_keys;						/*open addressing; 0 marks a free slot*/
+	uint8_t* visited_trees;						/*bit per engine color whose tree already passed the position*/
+	size_t visited_mask;
+	size_t visited_count;
+}Book_Builder;
+
+/*Marks the position as visited by the trees in tree_bits and returns the bits that were not visited before*/
+int mark_book_position(Book_Builder* builder, uint64_t hash_key, int tree_bits)
+{
+	size_t slot;
+	int new_bits;
+
+	if (builder->visited_count * 2 >= builder->visited_mask)
+	{
+		size_t old_capacity = builder->visited_mask + 1;
+		uint64_t* old_keys = builder->visited_keys;
+		uint8_t* old_trees = builder->visited_trees;
+
+		builder->visited_mask = old_capacity * 2 - 1;
+		builder->visited_keys = (uint64_t*)calloc(old_capacity * 2, sizeof(uint64_t));
+		builder->visited_trees = (uint8_t*)calloc(old_capacity * 2, sizeof(uint8_t));
+		builder->visited_count = 0;
+		for (size_t i = 0; i < old_capacity; i++)
+		{
+			if (old_keys[i] != 0)
+			{
+				mark_book_position(builder, old_keys[i], old_trees[i]);
+			}
+		}
+		free(old_keys);
+		free(old_trees);
+	}
+
+	/*a zero key would read as a free slot*/
+	hash_key = hash_key != 0 ? hash_key : 1;
+	slot = (size_t)hash_key & builder->visited_mask;
+	while (builder->visited_keys[slot] != 0 && builder->visited_keys[slot] != hash_key)
+	{
+		slot = (slot + 1) & builder->visited_mask;
+	}
+	if (builder->visited_keys[slot] == 0)
+	{
+		builder->visited_keys[slot] = hash_key;
+		builder->visited_count++;
+	}
+	new_bits = tree_bits & ~builder->visited_trees[slot];
+	builder->visited_trees[slot] |= (uint8_t)tree_bits;
+	return new_bits;
+}
+
+void add_book_entry(Book_Builder* builder, uint64_t hash_key, int best_move, int value, int depth)
+{
+	if (builder->entry_count == builder->entry_capacity)
+	{
+		builder->entry_capacity = builder->entry_capacity * 2 + 1024;
+		builder->entries = (Book_Entry*)realloc(builder->entries, builder->entry_capacity * sizeof(Book_Entry));
+	}
+	builder->entries[builder->entry_count].hash_key = hash_key;
+	builder->entries[builder->entry_count].value = value;
+	builder->entries[builder->entry_count].best_move = (int16_t)best_move;
+	builder->entries[builder->entry_count].depth = (int16_t)depth;
+	builder->entry_count++;
+}
+
+int compare_book_entries(const void* first, const void* second)
+{
+	uint64_t first_key = ((const Book_Entry*)first)->hash_key;
+	uint64_t second_key = ((const Book_Entry*)second)->hash_key;
+
+	return first_key < second_key ? -1 : (first_key > second_key);
+}
+
+/*Expands the position with color_index to move for the trees in tree_bits, ply moves into the game*/
+void build_book_position(Book_Builder* builder, Board_Cell** current_board, int color_index, int ply, int tree_bits)
+{
+	Reversi_Game* mover = builder->engines[color_index];
+	Search_Workspace* workspace = &mover->search_threads[MAIN_SEARCH_THREAD].workspace;
+	Move_List valid_moves;
+	Board_Cell** next_board;
+	int* moves;
+	int move_count;
+
+	if (ply >= builder->book_plies)
+	{
+		return;
+	}
+	tree_bits = mark_book_position(builder, get_board_hash_key(mover, current_board, color_index == BLACK_INDEX ? 'B' : 'W'), tree_bits);
+	if (tree_bits == ZERO)
+	{
+		return;
+	}
+
+	/*the search below reuses the arena, so the moves are copied out*/
+	valid_moves = get_valid_moves(mover, workspace, current_board, COMPUTER_PLAYER);
+	move_count = valid_moves.count;
+	moves = (int*)malloc((move_count > 0 ? move_count : 1) * sizeof(int));
+	memcpy(moves, valid_moves.moves, move_count * sizeof(int));
+	release_valid_moves(workspace, &valid_moves);
+
+	next_board = create_the_board(mover);
+	if (move_count == ZERO)
+	{
+		Reversi_Game* waiter = builder->engines[1 - color_index];
+		Move_List replies = get_valid_moves(waiter, &waiter->search_threads[MAIN_SEARCH_THREAD].workspace, current_board, COMPUTER_PLAYER);
+
+		if (!no_valid_moves_exist(&replies))
+		{
+			copy_the_board(mover, next_board, current_board);
+			build_book_position(builder, next_board, 1 - color_index, ply + 1, tree_bits);
+		}
+		release_valid_moves(&waiter->search_threads[MAIN_SEARCH_THREAD].workspace, &replies);
+	}
+	else
+	{
+		if (tree_bits & (1 << color_index))
+		{
+			Cell_Coordinates book_move = alpha_beta_search(mover, current_board, ZERO);
+			int square_index = book_move.row_index * builder->board_size + book_move.column_index;
+
+			add_book_entry(builder, get_board_hash_key(mover, current_board, color_index == BLACK_INDEX ? 'B' : 'W'), square_index, mover->last_search_value, mover->last_search_depth);
+			copy_the_board(mover, next_board, current_board);
+			apply_move_in_place(mover, next_board, book_move, COMPUTER_PLAYER, NULL);
+			build_book_position(builder, next_board, 1 - color_index, ply + 1, 1 << color_index);
+		}
+		if (tree_bits & (1 << (1 - color_index)))
+		{
+			for (int i = 0; i < move_count; i++)
+			{
+				copy_the_board(mover, next_board, current_board);
+				apply_move_in_place(mover, next_board, get_coordinates_from_square(mover, moves[i]), COMPUTER_PLAYER, NULL);
+				build_book_position(builder, next_board, 1 - color_index, ply + 1, 1 << (1 - color_index));
+			}
+		}
+	}
+	delete_the_board(mover, next_board);
+	free(moves);
+}
+
+bool write_opening_book(Book_Builder* builder, const char* path)
+{
+	FILE* book_file = fopen(path, "wb");
+	Book_Header header;
+	bool written;
+
+	if (book_file == NULL)
+	{
+		return false;
+	}
+	memcpy(header.magic, BOOK_MAGIC, sizeof(header.magic));
+	header.version = BOOK_VERSION;
+	header.board_size = (uint32_t)builder->board_size;
+	header.entry_count = (uint32_t)builder->entry_count;
+
+	written = fwrite(&header, sizeof(header), 1, book_file) == 1
+		&& fwrite(builder->entries, sizeof(Book_Entry), builder->entry_count, book_file) == builder->entry_count;
+	return fclose(book_file) == 0 && written;
+}
+
+/*book <size> <plies> <path> [option=value ...]: searches every position of the first plies moves that a game
+  against the engine can reach and writes the engine's moves, sorted by hash key, to path*/
+int run_book_builder(char* menu_arguments)
+{
+	const char s[2] = " ";
+	char* token;
+	char* book_path = NULL;
+	Reversi_Game* settings = create_reversi_game();
+	Book_Builder builder;
+	Board_Cell** start_board;
+	long long start_time;
+
+	memset(&builder, 0, sizeof(builder));
+	builder.board_size = INVALID_VALUE;
+	builder.book_plies = INVALID_VALUE;
+
+	token = strtok(menu_arguments, s);
+	for (int menu_item = 1; token != NULL; menu_item++)
+	{
+		if (menu_item == 1)
+		{
+			builder.board_size = atoi(token);
+		}
+		else if (menu_item == 2)
+		{
+			builder.book_plies = atoi(token);
+		}
+		else if (menu_item == 3)
+		{
+			book_path = token;
+		}
+		else if (strncmp(token, "level=", 6) == 0)
+		{
+			settings->game_level = atoi(token + 6);
+		}
+		else
+		{
+			parse_game_option(settings, token);
+		}
+		token = strtok(NULL, s);
+	}
+
+	if (builder.board_size < MIN_BOARD_SIZE || builder.board_size > MAX_BOARD_SIZE || builder.board_size % 2 != 0 || !is_valid_level(builder.book_plies)
+		|| book_path == NULL || !is_valid_level(settings->game_level))
+	{
+		printf("Invalid book: the size must be even and between %d and %d, at least 1 ply, a path and a level=<n>\n", MIN_BOARD_SIZE, MAX_BOARD_SIZE);
+		delete_reversi_game(settings);
+		return 1;
+	}
+
+	/*a book must not be built from another book*/
+	settings->book_path[0] = '\0';
+	initialize_zobrist_keys();
+	builder.engines[BLACK_INDEX] = create_self_play_engine(settings, builder.board_size, BLACK_INDEX);
+	builder.engines[WHITE_INDEX] = create_self_play_engine(settings, builder.board_size, WHITE_INDEX);
+	builder.visited_mask = 1023;
+	builder.visited_keys = (uint64_t*)calloc(builder.visited_mask + 1, sizeof(uint64_t));
+	builder.visited_trees = (uint8_t*)calloc(builder.visited_mask + 1, sizeof(uint8_t));
+	start_board = create_the_board(builder.engines[BLACK_INDEX]);
+	start_time = get_time_in_milliseconds();
+
+	build_book_position(&builder, start_board, BLACK_INDEX, ZERO, (1 << BLACK_INDEX) | (1 << WHITE_INDEX));
+	qsort(builder.entries, builder.entry_count, sizeof(Book_Entry), compare_book_entries);
+
+	if (write_opening_book(&builder, book_path))
+	{
+		printf("Opening book %s: %zu positions of %dx%d, %d plies, in %lld ms\n", book_path, builder.entry_count, builder.board_size, builder.board_size,
+			builder.book_plies, get_time_in_milliseconds() - start_time);
+	}
+	else
+	{
+		printf("Cannot write the opening book %s\n", book_path);
+	}
+
+	delete_the_board(builder.engines[BLACK_INDEX], start_board);
+	free(builder.entries);
+	free(builder.visited_keys);
+	free(builder.visited_trees);
+	delete_reversi_game(builder.engines[BLACK_INDEX]);
+	delete_reversi_game(builder.engines[WHITE_INDEX]);
+	delete_reversi_game(settings);
+	return 0;
+}
+
+/******************/
+/*PROBCUT CALIBRATION*/
+/******************/
+
+/*Sums for the least-squares fit of deep values against shallow values*/
+typedef struct
+{
+	double sample_count;
+	double shallow_sum;
+	double deep_sum;
+	double shallow_square_sum;
+	double deep_square_sum;
+	double product_sum;
+}Probcut_Sums;
+
+/*A position from a self-play game of the engines: random_plies random moves, then moves searched play_level deep,
+  up to sample_ply. Returns the color to move, or INVALID_VALUE when the game ended first*/
+int play_calibration_game(Reversi_Game** engines, Board_Cell** current_board, int random_plies, int sample_ply, int play_level, uint64_t* random_state)
+{
+	int color_to_move = BLACK_INDEX;
+	int passes = ZERO;
+
+	for (int ply = 0; ply < sample_ply && passes < 2; ply++)
+	{
+		Reversi_Game* mover = engines[color_to_move];
+		Move_List valid_moves = get_valid_moves(mover, &mover->search_threads[MAIN_SEARCH_THREAD].workspace, current_board, COMPUTER_PLAYER);
+		Cell_Coordinates move;
+
+		if (no_valid_moves_exist(&valid_moves))
+		{
+			release_valid_moves(&mover->search_threads[MAIN_SEARCH_THREAD].workspace, &valid_moves);
+			passes++;
+			color_to_move = 1 - color_to_move;
+			continue;
+		}
+		passes = ZERO;
+		if (ply < random_plies)
+		{
+			move = get_coordinates_from_square(mover, valid_moves.moves[get_next_random_key(random_state) % valid_moves.count]);
+			release_valid_moves(&mover->search_threads[MAIN_SEARCH_THREAD].workspace, &valid_moves);
+		}
+		else
+		{
+			release_valid_moves(&mover->search_threads[MAIN_SEARCH_THREAD].workspace, &valid_moves);
+			prepare_search_thread(&mover->search_threads[MAIN_SEARCH_THREAD], current_board);
+			search_to_depth(&mover->search_threads[MAIN_SEARCH_THREAD], play_level);
+			move = get_coordinates_from_square(mover, mover->search_threads[MAIN_SEARCH_THREAD].principal_move);
+		}
+		apply_move_in_place(mover, current_board, move, COMPUTER_PLAYER, NULL);
+		color_to_move = 1 - color_to_move;
+	}
+	return passes < 2 ? color_to_move : INVALID_VALUE;
+}
+
+/*probcut <size> <positions> <path> [option=value ...]: searches self-play positions to every depth up to maxdepth
+  and fits, per game stage and per pair of deep and shallow depth, the deep value as a line of the shallow one*/
+int run_probcut_calibration(char* menu_arguments)
+{
+	const char s[2] = " ";
+	char* token;
+	char* fits_path = NULL;
+	int board_size = INVALID_VALUE;
+	int position_count = INVALID_VALUE;
+	int max_depth = MPC_DEFAULT_CALIBRATION_DEPTH;
+	int random_plies = MPC_CALIBRATION_RANDOM_PLIES;
+	int play_level = MPC_CALIBRATION_GAME_LEVEL;
+	uint64_t random_state = ZOBRIST_SEED;
+	Reversi_Game* settings = create_reversi_game();
+	Reversi_Game* engines[2];
+	Probcut_Sums (*sums)[MPC_MAX_DEPTH + 1][MPC_CHECKS_PER_DEPTH];
+	int values[MPC_MAX_DEPTH + 1];
+	int positions_searched = ZERO;
+	FILE* fits_file;
+	long long start_time;
+
+	token = strtok(menu_arguments, s);
+	for (int menu_item = 1; token != NULL; menu_item++)
+	{
+		if (menu_item == 1)
+		{
+			board_size = atoi(token);
+		}
+		else if (menu_item == 2)
+		{
+			position_count = atoi(token);
+		}
+		else if (menu_item == 3)
+		{
+			fits_path = token;
+		}
+		else if (strncmp(token, "maxdepth=", 9) == 0)
+		{
+			max_depth = min(max(atoi(token + 9), MPC_MIN_DEPTH), MPC_MAX_DEPTH);
+		}
+		else if (strncmp(token, "level=", 6) == 0)
+		{
+			play_level = atoi(token + 6);
+		}
+		else if (strncmp(token, "random=", 7) == 0)
+		{
+			random_plies = max(atoi(token + 7), ZERO);
+		}
+		else if (strncmp(token, "seed=", 5) == 0)
+		{
+			random_state = strtoull(token + 5, NULL, 10);
+		}
+		else
+		{
+			parse_game_option(settings, token);
+		}
+		token = strtok(NULL, s);
+	}
+
+	/*a sample is taken after the random moves, before the board is full*/
+	if (board_size < MIN_BOARD_SIZE || board_size > MAX_BOARD_SIZE || board_size % 2 != 0 || !is_valid_level(position_count) || fits_path == NULL
+		|| !is_valid_level(play_level) || random_plies > board_size * board_size - 5)
+	{
+		printf("Invalid calibration: the size must be even and between %d and %d, at least 1 position, a path, and at most size*size - 5 random moves\n",
+			MIN_BOARD_SIZE, MAX_BOARD_SIZE);
+		delete_reversi_game(settings);
+		return 1;
+	}
+
+	/*the workspaces must hold the deepest search, and the fits must come from the plain search, not from one
+	  cut by older fits*/
+	settings->game_level = max_depth;
+	settings->probcut_path[0] = '\0';
+	settings->book_path[0] = '\0';
+	settings->move_time_limit = NO_TIME_LIMIT;
+	settings->game_clock_remaining = NO_TIME_LIMIT;
+	initialize_zobrist_keys();
+	engines[BLACK_INDEX] = create_self_play_engine(settings, board_size, BLACK_INDEX);
+	engines[WHITE_INDEX] = create_self_play_engine(settings, board_size, WHITE_INDEX);
+	sums = calloc(MPC_STAGES, sizeof(*sums));
+	start_time = get_time_in_milliseconds();
+
+	while (positions_searched < position_count)
+	{
+		Board_Cell** sample_board = create_the_board(engines[BLACK_INDEX]);
+		int sample_ply = random_plies + (int)(get_next_random_key(&random_state) % (uint64_t)(board_size * board_size - 4 - random_plies));
+		int color_to_move = play_calibration_game(engines, sample_board, random_plies, sample_ply, play_level, &random_state);
+
+		if (color_to_move != INVALID_VALUE)
+		{
+			Reversi_Game* mover = engines[color_to_move];
+			Search_Thread* thread = &mover->search_threads[MAIN_SEARCH_THREAD];
+			int stage;
+
+			mover->search_aborted = false;
+			mover->search_deadline = NO_TIME_LIMIT;
+			prepare_search_thread(thread, sample_board);
+			stage = get_probcut_stage(mover, thread->position.empty_count);
+
+			for (int depth = 1; depth <= max_depth; depth++)
+			{
+				values[depth] = search_to_depth(thread, depth).value;
+			}
+			for (int depth = MPC_MIN_DEPTH; depth <= max_depth; depth++)
+			{
+				for (int check = 0; check < MPC_CHECKS_PER_DEPTH; check++)
+				{
+					int shallow_depth = get_probcut_shallow_depth(depth, check);
+					Probcut_Sums* pair_sums = &sums[stage][depth][check];
+
+					if (shallow_depth < 1)
+					{
+						continue;
+					}
+					pair_sums->sample_count += 1.0;
+					pair_sums->shallow_sum += values[shallow_depth];
+					pair_sums->deep_sum += values[depth];
+					pair_sums->shallow_square_sum += (double)values[shallow_depth] * values[shallow_depth];
+					pair_sums->deep_square_sum += (double)values[depth] * values[depth];
+					pair_sums->product_sum += (double)values[shallow_depth] * values[depth];
+				}
+			}
+			positions_searched++;
+		}
+		delete_the_board(engines[BLACK_INDEX], sample_board);
+	}
+
+	fits_file = fopen(fits_path, "w");
+	if (fits_file == NULL)
+	{
+		printf("Cannot write the ProbCut calibration %s\n", fits_path);
+	}
+	else
+	{
+		fprintf(fits_file, "# ProbCut calibration: stage depth check slope intercept deviation samples\n");
+		fprintf(fits_file, "size %d\n", board_size);
+		fprintf(fits_file, "eval %s\n", get_evaluation_name(settings->evaluation));
+		for (int stage = 0; stage < MPC_STAGES; stage++)
+		{
+			for (int depth = MPC_MIN_DEPTH; depth <= max_depth; depth++)
+			{
+				for (int check = 0; check < MPC_CHECKS_PER_DEPTH; check++)
+				{
+					Probcut_Sums* pair_sums = &sums[stage][depth][check];
+					double n = pair_sums->sample_count;
+					double shallow_variance, covariance, slope, intercept, residual;
+
+					if (n < MPC_MIN_SAMPLES)
+					{
+						continue;
+					}
+					shallow_variance = pair_sums->shallow_square_sum / n - (pair_sums->shallow_sum / n) * (pair_sums->shallow_sum / n);
+					covariance = pair_sums->product_sum / n - (pair_sums->shallow_sum / n) * (pair_sums->deep_sum / n);
+					if (shallow_variance <= 0.0)
+					{
+						continue;
+					}
+					slope = covariance / shallow_variance;
+					intercept = pair_sums->deep_sum / n - slope * pair_sums->shallow_sum / n;
+					/*mean squared error of the fitted line*/
+					residual = (pair_sums->deep_square_sum - 2 * slope * pair_sums->product_sum - 2 * intercept * pair_sums->deep_sum
+						+ slope * slope * pair_sums->shallow_square_sum + 2 * slope * intercept * pair_sums->shallow_sum + intercept * intercept * n) / n;
+					/*rounding can leave a perfect fit slightly below zero*/
+					fprintf(fits_file, "%d %d %d %.6f %.6f %.6f %d\n", stage, depth, check, slope, intercept, sqrt(residual > 0 ? residual : 0), (int)n);
+				}
+			}
+		}
+		fclose(fits_file);
+		printf("ProbCut calibration %s: %d positions of %dx%d, depths %d to %d, in %lld ms\n", fits_path, positions_searched, board_size, board_size,
+			MPC_MIN_DEPTH, max_depth, get_time_in_milliseconds() - start_time);
+	}
+
+	free(sums);
+	delete_reversi_game(engines[BLACK_INDEX]);
+	delete_reversi_game(engines[WHITE_INDEX]);
+	delete_reversi_game(settings);
+	return fits_file == NULL;
+}
+
+/******************/
+/*BATCH ANALYSIS*/
+/******************/
+
+/*One position between the reader, the workers and the writer. A slot is reused once its result is written, so the
+  queue holds at most slot_count positions however long the input is*/
+typedef struct
+{
+	int state;									/*BATCH_SLOT_EMPTY, _QUEUED, _SEARCHING or _DONE*/
+	long long position_index;
+	int color_index;							/*side to move, or INVALID_VALUE for an unreadable position*/
+	char* cells;								/*size*size of B, W or -, as for perft*/
+	char result[BATCH_RESULT_LENGTH];
+}Batch_Slot;
+
+typedef struct
+{
+	Reversi_Game* settings;
+	int board_size;
+	Batch_Slot* slots;
+	int slot_count;
+	long long queued_count;						/*positions read so far*/
+	long long next_position;					/*first position no worker has taken*/
+	long long written_count;
+	bool input_done;
+	Mutex_Handle lock;							/*guards the slot states and the counters*/
+	Condition_Handle changed;					/*signalled whenever a slot changes state or the input ends*/
+	unsigned long long nodes_searched;
+}Batch_Queue;
+
+/*Searches the position of the slot for its side to move and formats "<index> <move> <score> <depth> <nodes>". The
+  score is the search value for the side to move. A side without moves passes and gets the negated value of the
+  opponent's search; a finished game gets its disc margin*/
+void analyse_batch_position(Reversi_Game** engines, Board_Cell** current_board, Batch_Slot* slot)
+{
+	Reversi_Game* mover;
+	Move_List valid_moves;
+	Cell_Coordinates move;
+	char move_text[PROTOCOL_MOVE_LENGTH];
+	bool must_pass;
+
+	if (slot->color_index == INVALID_VALUE || !load_board_position(engines[BLACK_INDEX], current_board, slot->cells))
+	{
+		snprintf(slot->result, BATCH_RESULT_LENGTH, "%lld invalid\n", slot->position_index);
+		return;
+	}
+
+	mover = engines[slot->color_index];
+	valid_moves = get_valid_moves(mover, &mover->search_threads[MAIN_SEARCH_THREAD].workspace, current_board, COMPUTER_PLAYER);
+	must_pass = no_valid_moves_exist(&valid_moves);
+	release_valid_moves(&mover->search_threads[MAIN_SEARCH_THREAD].workspace, &valid_moves);
+	if (must_pass)
+	{
+		Reversi_Game* opponent = engines[1 - slot->color_index];
+
+		valid_moves = get_valid_moves(opponent, &opponent->search_threads[MAIN_SEARCH_THREAD].workspace, current_board, COMPUTER_PLAYER);
+		if (no_valid_moves_exist(&valid_moves))
+		{
+			release_valid_moves(&opponent->search_threads[MAIN_SEARCH_THREAD].workspace, &valid_moves);
+			update_disks_count(mover, current_board);
+			snprintf(slot->result, BATCH_RESULT_LENGTH, "%lld end %d 0 0\n", slot->position_index, get_the_score(mover, COMPUTER_PLAYER));
+			return;
+		}
+		release_valid_moves(&opponent->search_threads[MAIN_SEARCH_THREAD].workspace, &valid_moves);
+		alpha_beta_search(opponent, current_board, ZERO);
+		snprintf(slot->result, BATCH_RESULT_LENGTH, "%lld pass %d %d %llu\n", slot->position_index, -opponent->last_search_value,
+			opponent->last_search_depth, opponent->last_search_statistics.nodes);
+		return;
+	}
+
+	move = alpha_beta_search(mover, current_board, ZERO);
+	format_move_text(mover, move.row_index * mover->board_size + move.column_index, move_text);
+	snprintf(slot->result, BATCH_RESULT_LENGTH, "%lld %s %d %d %llu\n", slot->position_index, move_text,
+		mover->last_search_value, mover->last_search_depth, mover->last_search_statistics.nodes);
+}
+
+/*Takes queued positions in input order until the input is done and the queue is empty. Every worker searches with
+  its own pair of engines, one per side to move, so their transposition tables never mix the two points of view.
+  Both are cleared before each position*/
+THREAD_FUNCTION run_batch_worker(void* argument)
+{
+	Batch_Queue* queue = (Batch_Queue*)argument;
+	Reversi_Game* engines[2];
+	Board_Cell** current_board;
+
+	engines[BLACK_INDEX] = create_self_play_engine(queue->settings, queue->board_size, BLACK_INDEX);
+	engines[WHITE_INDEX] = create_self_play_engine(queue->settings, queue->board_size, WHITE_INDEX);
+	current_board = create_the_board(engines[BLACK_INDEX]);
+
+	for (;;)
+	{
+		Batch_Slot* slot;
+		unsigned long long nodes_searched;
+
+		lock_mutex(&queue->lock);
+		while (queue->next_position == queue->queued_count && !queue->input_done)
+		{
+			wait_condition(&queue->changed, &queue->lock);
+		}
+		if (queue->next_position == queue->queued_count)
+		{
+			unlock_mutex(&queue->lock);
+			break;
+		}
+		slot = &queue->slots[queue->next_position++ % queue->slot_count];
+		slot->state = BATCH_SLOT_SEARCHING;
+		unlock_mutex(&queue->lock);
+
+		/*every result depends on its position alone, not on what this worker searched before*/
+		clear_search_memory(engines[BLACK_INDEX]);
+		clear_search_memory(engines[WHITE_INDEX]);
+		engines[BLACK_INDEX]->last_search_statistics.nodes = ZERO;
+		engines[WHITE_INDEX]->last_search_statistics.nodes = ZERO;
+		analyse_batch_position(engines, current_board, slot);
+		nodes_searched = engines[BLACK_INDEX]->last_search_statistics.nodes + engines[WHITE_INDEX]->last_search_statistics.nodes;
+
+		lock_mutex(&queue->lock);
+		slot->state = BATCH_SLOT_DONE;
+		queue->nodes_searched += nodes_searched;
+		signal_all_condition(&queue->changed);
+		unlock_mutex(&queue->lock);
+	}
+
+	delete_the_board(engines[BLACK_INDEX], current_board);
+	delete_reversi_game(engines[BLACK_INDEX]);
+	delete_reversi_game(engines[WHITE_INDEX]);
+	THREAD_RETURN;
+}
+
+/*Writes the results that are done, in input order, and frees their slots. Called with the lock held*/
+void write_batch_results(Batch_Queue* queue, FILE* output_file)
+{
+	while (queue->written_count < queue->queued_count)
+	{
+		Batch_Slot* slot = &queue->slots[queue->written_count % queue->slot_count];
+
+		if (slot->state != BATCH_SLOT_DONE)
+		{
+			break;
+		}
+		fputs(slot->result, output_file);
+		slot->state = BATCH_SLOT_EMPTY;
+		queue->written_count++;
+	}
+}
+
+/*Waits for a free slot, writing finished results meanwhile, and returns it. Called with the lock held*/
+Batch_Slot* get_free_batch_slot(Batch_Queue* queue, FILE* output_file)
+{
+	for (;;)
+	{
+		write_batch_results(queue, output_file);
+		if (queue->queued_count - queue->written_count < queue->slot_count)
+		{
+			return &queue->slots[queue->queued_count % queue->slot_count];
+		}
+		wait_condition(&queue->changed, &queue->lock);
+	}
+}
+
+/*The next text position, "<cells> black|white", into cells of room for cell_count cells. Empty lines and lines
+  starting with # are skipped. Returns the side to move, INVALID_VALUE for a line that is not a position, or EOF at
+  the end of the input*/
+int read_text_batch_position(FILE* input_file, char* line, int line_length, char* cells, int cell_count)
+{
+	for (;;)
+	{
+		if (fgets(line, line_length, input_file) == NULL)
+		{
+			return EOF;
+		}
+		if (strchr(line, '\n') == NULL && !feof(input_file))
+		{
+			int character;
+
+			/*longer than any position: skip the rest of the line*/
+			while ((character = fgetc(input_file)) != '\n' && character != EOF)
+			{
+			}
+			return INVALID_VALUE;
+		}
+		line += strspn(line, " \t");
+		if (line[0] == '#' || line[0] == '\r' || line[0] == '\n' || line[0] == '\0')
+		{
+			continue;
+		}
+		return parse_position_text(line, cells, cell_count);
+	}
+}
+
+/*The next position in the encoding of encode_position*/
+int read_binary_batch_position(FILE* input_file, int board_size, unsigned char* encoded, char* cells)
+{
+	int encoded_length = get_encoded_position_length(board_size);
+	int color_index;
+
+	if (fread(encoded, 1, encoded_length, input_file) != (size_t)encoded_length)
+	{
+		return EOF;
+	}
+	return decode_positions(encoded, 1, board_size * board_size, cells, &color_index) == 1 ? color_index : INVALID_VALUE;
+}
+
+/*batch <size> <level> [option=value ...]: searches every position of the input with the newgame options and
+  writes one result line per position, in input order, while worker threads search the positions after it*/
+int run_batch_analysis(char* menu_arguments)
+{
+	const char s[2] = " ";
+	char* token;
+	char* input_path = NULL;
+	char* output_path = NULL;
+	bool binary_input = false;
+	int worker_count = 1;
+	int slot_count = INVALID_VALUE;
+	int workers_started = ZERO;
+	int line_length;
+	char* line;
+	unsigned char* encoded;
+	FILE* input_file = stdin;
+	FILE* output_file = stdout;
+	Thread_Handle* workers;
+	Batch_Queue queue;
+	long long start_time;
+	long long elapsed_time;
+	double elapsed_seconds;
+
+	memset(&queue, 0, sizeof(queue));
+	queue.settings = create_reversi_game();
+	queue.board_size = INVALID_VALUE;
+
+	token = strtok(menu_arguments, s);
+	for (int menu_item = 1; token != NULL; menu_item++)
+	{
+		if (menu_item == 1)
+		{
+			queue.board_size = atoi(token);
+		}
+		else if (menu_item == 2)
+		{
+			queue.settings->game_level = atoi(token);
+		}
+		else if (strncmp(token, "input=", 6) == 0)
+		{
+			input_path = strcmp(token + 6, "-") == 0 ? NULL : token + 6;
+		}
+		else if (strncmp(token, "output=", 7) == 0)
+		{
+			output_path = strcmp(token + 7, "-") == 0 ? NULL : token + 7;
+		}
+		else if (strncmp(token, "format=", 7) == 0)
+		{
+			binary_input = strcmp(token + 7, "binary") == 0;
+		}
+		else if (strncmp(token, "workers=", 8) == 0)
+		{
+			worker_count = min(max(atoi(token + 8), 1), MAX_SEARCH_THREADS);
+		}
+		else if (strncmp(token, "queue=", 6) == 0)
+		{
+			slot_count = max(atoi(token + 6), 1);
+		}
+		else
+		{
+			parse_game_option(queue.settings, token);
+		}
+		token = strtok(NULL, s);
+	}
+
+	if (queue.board_size < MIN_BOARD_SIZE || queue.board_size > MAX_BOARD_SIZE || queue.board_size % 2 != 0 || !is_valid_level(queue.settings->game_level))
+	{
+		printf("Invalid batch: the size must be even and between %d and %d, the level at least 1\n", MIN_BOARD_SIZE, MAX_BOARD_SIZE);
+		delete_reversi_game(queue.settings);
+		return 1;
+	}
+	if (input_path != NULL && (input_file = fopen(input_path, binary_input ? "rb" : "r")) == NULL)
+	{
+		printf("Cannot read the positions %s\n", input_path);
+		delete_reversi_game(queue.settings);
+		return 1;
+	}
+	if (output_path != NULL && (output_file = fopen(output_path, "w")) == NULL)
+	{
+		printf("Cannot write the results %s\n", output_path);
+		if (input_file != stdin)
+		{
+			fclose(input_file);
+		}
+		delete_reversi_game(queue.settings);
+		return 1;
+	}
+#ifdef _WIN32
+	if (binary_input && input_file == stdin)
+	{
+		_setmode(_fileno(stdin), _O_BINARY);
+	}
+#endif
+
+	/*a few positions per worker keep them busy while the writer waits for the slowest one*/
+	queue.slot_count = slot_count != INVALID_VALUE ? slot_count : worker_count * BATCH_SLOTS_PER_WORKER;
+	queue.slots = (Batch_Slot*)calloc(queue.slot_count, sizeof(Batch_Slot));
+	for (int i = 0; i < queue.slot_count; i++)
+	{
+		queue.slots[i].cells = (char*)malloc(queue.board_size * queue.board_size + 1);
+	}
+	line_length = queue.board_size * queue.board_size + MENU_INPUT_LENGTH;
+	line = (char*)malloc(line_length);
+	encoded = (unsigned char*)malloc(get_encoded_position_length(queue.board_size));
+
+	initialize_zobrist_keys();
+	create_mutex(&queue.lock);
+	create_condition(&queue.changed);
+	workers = (Thread_Handle*)malloc(worker_count * sizeof(Thread_Handle));
+	start_time = get_time_in_milliseconds();
+
+	for (int i = 0; i < worker_count; i++)
+	{
+		if (!start_thread(&workers[i], run_batch_worker, &queue))
+		{
+			break;
+		}
+		workers_started++;
+	}
+
+	if (workers_started == ZERO)
+	{
+		printf("Cannot start the batch workers\n");
+	}
+	else
+	{
+		/*results on stdout start below the menu prompt*/
+		if (output_file == stdout)
+		{
+			fputs("\n", output_file);
+		}
+		lock_mutex(&queue.lock);
+		for (;;)
+		{
+			Batch_Slot* slot = get_free_batch_slot(&queue, output_file);
+			int color_index;
+
+			/*the workers keep searching while the next position is read*/
+			unlock_mutex(&queue.lock);
+			if (binary_input)
+			{
+				color_index = read_binary_batch_position(input_file, queue.board_size, encoded, slot->cells);
+			}
+			else
+			{
+				color_index = read_text_batch_position(input_file, line, line_length, slot->cells, queue.board_size * queue.board_size);
+			}
+			lock_mutex(&queue.lock);
+			if (color_index == EOF)
+			{
+				break;
+			}
+			slot->color_index = color_index;
+			slot->position_index = queue.queued_count++;
+			slot->state = BATCH_SLOT_QUEUED;
+			signal_all_condition(&queue.changed);
+		}
+		queue.input_done = true;
+		signal_all_condition(&queue.changed);
+		while (queue.written_count < queue.queued_count)
+		{
+			write_batch_results(&queue, output_file);
+			if (queue.written_count < queue.queued_count)
+			{
+				wait_condition(&queue.changed, &queue.lock);
+			}
+		}
+		unlock_mutex(&queue.lock);
+	}
+	for (int i = 0; i < workers_started; i++)
+	{
+		join_thread(&workers[i]);
+	}
+	elapsed_time = get_time_in_milliseconds() - start_time;
+	elapsed_seconds = (elapsed_time > 0 ? elapsed_time : 1) / 1000.0;
+
+	/*the results may be on stdout*/
+	fprintf(output_file == stdout ? stderr : stdout, "Batch: %lld positions on %dx%d, %d workers, %.2f positions/sec, %.0f nodes/sec\n",
+		queue.queued_count, queue.board_size, queue.board_size, workers_started, queue.queued_count / elapsed_seconds, queue.nodes_searched / elapsed_seconds);
+
+	if (input_file != stdin)
 	{
+		fclose(input_file);
+	}
+	if (output_file != stdout)
+	{
+		fclose(output_file);
+	}
+	for (int i = 0; i < queue.slot_count; i++)
+	{
+		free(queue.slots[i].cells);
+	}
+	free(queue.slots);
+	free(line);
+	free(encoded);
+	free(workers);
+	delete_condition(&queue.changed);
+	delete_mutex(&queue.lock);
+	delete_reversi_game(queue.settings);
+
+	return workers_started == ZERO;
+}
+
+/******************/
+/*RECORD REPLAY*/
+/******************/
+
+/*The positions a replay passes through, as text cells one position after the other*/
+typedef struct
+{
+	char* cells;
+	int* color_indexes;
+	int count;
+	int capacity;
+}Replay_Positions;
+
+void add_replay_position(Replay_Positions* positions, Reversi_Game* game, int color_index)
+{
+	int cell_count = game->board_size * game->board_size;
+	char* cells;
+
+	if (positions->count == positions->capacity)
+	{
+		positions->capacity = positions->capacity * 2 + 64;
+		positions->cells = (char*)realloc(positions->cells, (size_t)positions->capacity * cell_count);
+		positions->color_indexes = (int*)realloc(positions->color_indexes, positions->capacity * sizeof(int));
+	}
+	cells = positions->cells + (size_t)positions->count * cell_count;
+	for (int i = 0; i < cell_count; i++)
+	{
+		cells[i] = game->board[i / game->board_size][i % game->board_size].cell_disk_color;
+	}
+	positions->color_indexes[positions->count++] = color_index;
+}
+
+/*Encodes all the positions in one pass and writes them as the binary batch input. Returns false on a write error*/
+bool write_replay_positions(Replay_Positions* positions, int board_size, FILE* positions_file)
+{
+	size_t encoded_length = get_encoded_position_length(board_size);
+	unsigned char* encoded = (unsigned char*)malloc(encoded_length * positions->count);
+	bool is_written;
+
+	encode_positions(positions->cells, positions->color_indexes, positions->count, board_size * board_size, encoded);
+	is_written = fwrite(encoded, encoded_length, positions->count, positions_file) == (size_t)positions->count;
+	free(encoded);
+	return is_written;
+}
+
+/*replay <path> [positions=<path>]: plays a game record through from the initial position, checking every move, and
+  prints the moves, the final position in text and encoded form, and the disk counts. positions= also writes every
+  position of the game, the last included, in the binary batch input format*/
+int run_record_replay(char* menu_arguments)
+{
+	char* record_path = strtok(menu_arguments, " ");
+	char* positions_path = NULL;
+	char* token;
+	FILE* record_file = record_path != NULL ? fopen(record_path, "rb") : NULL;
+	FILE* positions_file = NULL;
+	Replay_Positions positions = { NULL, NULL, ZERO, ZERO };
+	Reversi_Game* game;
+	Search_Workspace* workspace;
+	unsigned char* encoded;
+	char* cells;
+	char* text;
+	int board_size;
+	int color_to_move = BLACK_INDEX;
+	int move_count = ZERO;
+	int square_index;
+	bool record_is_legal = true;
+	bool positions_written = true;
+
+	if (record_file == NULL)
+	{
+		printf("Cannot read the game record %s\n", record_path != NULL ? record_path : "");
+		return 1;
+	}
+	board_size = read_record_header(record_file);
+	if (board_size == INVALID_VALUE)
+	{
+		printf("%s is not a game record\n", record_path);
+		fclose(record_file);
+		return 1;
+	}
+	while ((token = strtok(NULL, " ")) != NULL)
+	{
+		if (strncmp(token, "positions=", 10) == 0)
+		{
+			positions_path = token + 10;
+		}
+	}
+	if (positions_path != NULL && (positions_file = fopen(positions_path, "wb")) == NULL)
+	{
+		printf("Cannot write the positions file %s\n", positions_path);
+		fclose(record_file);
+		return 1;
+	}
+
+	/*the computer plays black, so a player type follows from the color to move*/
+	game = create_reversi_game();
+	game->board_size = board_size;
+	game->game_level = 1;
+	game->transposition_table_megabytes = ZERO;
+	strcpy(game->computer_disk_color, "Black");
+	strcpy(game->user_disk_color, "White");
+	initialize_zobrist_keys();
+	start_reversi_game(game);
+	workspace = &game->search_threads[MAIN_SEARCH_THREAD].workspace;
+
+	printf("Record: %dx%d\n", board_size, board_size);
+	while ((square_index = read_record_move(record_file, board_size)) != EOF)
+	{
+		int player_type = color_to_move == BLACK_INDEX ? COMPUTER_PLAYER : USER_PLAYER;
+		Move_List valid_moves = get_valid_moves(game, workspace, game->board, player_type);
+		bool move_is_legal = square_index == INVALID_VALUE ? no_valid_moves_exist(&valid_moves) : false;
+
+		if (positions_file != NULL)
+		{
+			add_replay_position(&positions, game, color_to_move);
+		}
+		for (int i = 0; i < valid_moves.count && square_index != INVALID_VALUE; i++)
+		{
+			move_is_legal |= valid_moves.moves[i] == square_index;
+		}
+		release_valid_moves(workspace, &valid_moves);
+		if (!move_is_legal)
+		{
+			printf("\nMove %d is not legal\n", move_count + 1);
+			record_is_legal = false;
+			break;
+		}
+
+		if (square_index == INVALID_VALUE)
+		{
+			printf("%spass", move_count == ZERO ? "" : " ");
+		}
+		else
+		{
+			char move_text[PROTOCOL_MOVE_LENGTH];
+
+			format_move_text(game, square_index, move_text);
+			printf("%s%s", move_count == ZERO ? "" : " ", move_text);
+			register_move(game, game->board, get_coordinates_from_square(game, square_index), player_type);
+		}
+		color_to_move = 1 - color_to_move;
+		move_count++;
+	}
+	fclose(record_file);
+
+	encoded = (unsigned char*)malloc(get_encoded_position_length(board_size));
+	cells = (char*)malloc(board_size * board_size + 1);
+	text = (char*)malloc(board_size * board_size + MENU_INPUT_LENGTH);
+	encode_position(game, game->board, color_to_move, encoded);
+	decode_cells(encoded + 1, board_size * board_size, cells);
+	format_position_text(cells, color_to_move, text);
+	printf("\n%d moves\nPosition: %s\nEncoded: ", move_count, text);
+	for (int i = 0; i < get_encoded_position_length(board_size); i++)
+	{
+		printf("%02x", encoded[i]);
+	}
+	printf("\nWhite: %d - Black: %d\n", game->current_white_disks, game->current_black_disks);
+
+	if (positions_file != NULL)
+	{
+		/*an illegal move ends the replay; its position is written already*/
+		if (record_is_legal)
+		{
+			add_replay_position(&positions, game, color_to_move);
+		}
+		positions_written = write_replay_positions(&positions, board_size, positions_file);
+		positions_written &= fclose(positions_file) == 0;
+		if (!positions_written)
+		{
+			printf("Cannot write the positions file %s\n", positions_path);
+		}
+		else
+		{
+			printf("%d positions written to %s\n", positions.count, positions_path);
+		}
+		free(positions.cells);
+		free(positions.color_indexes);
+	}
+	free(encoded);
+	free(cells);
+	free(text);
+	delete_reversi_game(game);
+	return record_is_legal && positions_written ? 0 : 1;
+}
+
+/******************/
+/*MACHINE PROTOCOL*/
+/******************/
+
+/*The state of a protocol session: the position, the engines that search it and the search running on a copy*/
+typedef struct
+{
+	Reversi_Game* engines[2];					/*one per side to move, as in self-play*/
+	Board_Cell** board;
+	Board_Cell** search_board;
+	int color_to_move;
+	int max_level;								/*depth of go without a depth, and the deepest one allowed*/
+	int move_time_limit;						/*time of go without a time: the time option, or PROTOCOL_UNLIMITED_TIME*/
+	Thread_Handle search_handle;
+	bool searching;								/*a go has started and nobody has joined it yet*/
+	int search_color;
+	Mutex_Handle output_lock;					/*the search thread answers go while the main thread answers the rest*/
+	char* response;
+	Search_Statistics statistics;				/*of the last go that answered, guarded by output_lock*/
+	int search_depth;
+	long long search_time;
+}Protocol_Session;
+
+/*Writes one response line with a single buffered write*/
+void write_protocol_response(Protocol_Session* session, const char* response)
+{
+	lock_mutex(&session->output_lock);
+	fwrite(response, 1, strlen(response), stdout);
+	fflush(stdout);
+	unlock_mutex(&session->output_lock);
+}
+
+/*Answers go with the counters of its search, which stats reports without waiting for the next go*/
+void write_protocol_search_response(Protocol_Session* session, Reversi_Game* mover, const char* response)
+{
+	lock_mutex(&session->output_lock);
+	session->statistics = mover->last_search_statistics;
+	session->search_depth = mover->last_search_depth;
+	session->search_time = mover->last_search_time;
+	fwrite(response, 1, strlen(response), stdout);
+	fflush(stdout);
+	unlock_mutex(&session->output_lock);
+}
+
+/*Answers go: "bestmove <move> score <value> depth <depth> nodes <nodes> time <ms>", the move being pass when the side
+  to move has none and none, with the disc margin as the score, when the game is over*/
+THREAD_FUNCTION run_protocol_search(void* argument)
+{
+	Protocol_Session* session = (Protocol_Session*)argument;
+	Reversi_Game* mover = session->engines[session->search_color];
+	Reversi_Game* opponent = session->engines[1 - session->search_color];
+	Search_Workspace* workspace = &mover->search_threads[MAIN_SEARCH_THREAD].workspace;
+	Move_List valid_moves = get_valid_moves(mover, workspace, session->search_board, COMPUTER_PLAYER);
+	char response[PROTOCOL_RESPONSE_LENGTH];
+	char move_text[PROTOCOL_MOVE_LENGTH];
+	bool must_pass = no_valid_moves_exist(&valid_moves);
+	Cell_Coordinates move;
+
+	release_valid_moves(workspace, &valid_moves);
+	if (must_pass)
+	{
+		workspace = &opponent->search_threads[MAIN_SEARCH_THREAD].workspace;
+		valid_moves = get_valid_moves(opponent, workspace, session->search_board, COMPUTER_PLAYER);
+		strcpy(move_text, no_valid_moves_exist(&valid_moves) ? "none" : "pass");
+		release_valid_moves(workspace, &valid_moves);
+		update_disks_count(mover, session->search_board);
+		memset(&mover->last_search_statistics, 0, sizeof(mover->last_search_statistics));
+		mover->last_search_depth = ZERO;
+		mover->last_search_time = ZERO;
+		snprintf(response, sizeof(response), "bestmove %s score %d depth 0 nodes 0 time 0\n", move_text,
+			strcmp(move_text, "none") == 0 ? get_the_score(mover, COMPUTER_PLAYER) : 0);
+		write_protocol_search_response(session, mover, response);
+		THREAD_RETURN;
+	}
 
+	move = get_book_move(mover, session->search_board);
+	if (move.row_index == INVALID_VALUE)
+	{
+		move = alpha_beta_search(mover, session->search_board, ZERO);
 	}
 	else
 	{
-		register_move(board, computer_move_coodinates, COMPUTER_PLAYER);
+		memset(&mover->last_search_statistics, 0, sizeof(mover->last_search_statistics));
+		mover->last_search_depth = ZERO;
+		mover->last_search_time = ZERO;
 	}
+	format_move_text(mover, move.row_index * mover->board_size + move.column_index, move_text);
+	snprintf(response, sizeof(response), "bestmove %s score %d depth %d nodes %llu time %lld\n", move_text, mover->last_search_value,
+		mover->last_search_depth, mover->last_search_statistics.nodes, mover->last_search_time);
+	write_protocol_search_response(session, mover, response);
+	THREAD_RETURN;
+}
 
-	computer_move_coodinates.board_row = computer_move_coodinates.row_index + 1;
-	computer_move_coodinates.board_column = computer_move_coodinates.column_index + 'a';
+/*Stops the running go at its next clock check and waits for it; the deepest finished move is still answered*/
+void stop_protocol_search(Protocol_Session* session)
+{
+	if (!session->searching)
+	{
+		return;
+	}
+	session->engines[session->search_color]->stop_requested = true;
+	join_thread(&session->search_handle);
+	session->searching = false;
+}
 
-	return computer_move_coodinates;
+/*go [depth=<n>] [time=<ms>]: searches the position on a copy, so that every other command keeps working meanwhile.
+  The search deepens one level at a time, which lets stop end it with the deepest finished move. Without time= it
+  gets the session's move_time_limit*/
+void start_protocol_search(Protocol_Session* session, char* arguments)
+{
+	Reversi_Game* mover = session->engines[session->color_to_move];
+	int search_depth = session->max_level;
+	int time_limit = session->move_time_limit;
+
+	stop_protocol_search(session);
+	for (char* token = strtok(arguments, " "); token != NULL; token = strtok(NULL, " "))
+	{
+		if (strncmp(token, "depth=", 6) == 0)
+		{
+			search_depth = min(max(atoi(token + 6), 1), session->max_level);
+		}
+		else if (strncmp(token, "time=", 5) == 0)
+		{
+			time_limit = max(atoi(token + 5), 1);
+		}
+	}
+
+	mover->game_level = search_depth;
+	mover->move_time_limit = time_limit;
+	mover->stop_requested = false;
+	copy_the_board(mover, session->search_board, session->board);
+	session->search_color = session->color_to_move;
+	session->searching = start_thread(&session->search_handle, run_protocol_search, session);
+	if (!session->searching)
+	{
+		write_protocol_response(session, "error cannot start the search\n");
+	}
 }
 
-Game_Status play_game()
+/*Plays one move in the text of format_move_text, or pass, for the side to move. Returns false when it is illegal*/
+bool play_protocol_move(Protocol_Session* session, const char* move_text)
 {
-	Cell_Coordinates current_move = { INVALID_VALUE, INVALID_VALUE,' ', INVALID_VALUE };
+	Reversi_Game* mover = session->engines[session->color_to_move];
+	Search_Workspace* workspace = &mover->search_threads[MAIN_SEARCH_THREAD].workspace;
+	Move_List valid_moves = get_valid_moves(mover, workspace, session->board, COMPUTER_PLAYER);
+	Cell_Coordinates move;
+	bool move_is_legal;
 
-	
-	if (current_input_command == NULL)
+	if (strcmp(move_text, "pass") == 0)
+	{
+		move_is_legal = no_valid_moves_exist(&valid_moves);
+	}
+	else
+	{
+		move_is_legal = parse_move_text(mover, move_text, &move) && is_move_allowed(mover, &valid_moves, move);
+	}
+	release_valid_moves(workspace, &valid_moves);
+	if (!move_is_legal)
+	{
+		return false;
+	}
+	if (strcmp(move_text, "pass") != 0)
+	{
+		apply_move_in_place(mover, session->board, move, COMPUTER_PLAYER, NULL);
+	}
+	session->color_to_move = 1 - session->color_to_move;
+	return true;
+}
+
+/*position startpos|<cells> black|white [moves <move> ...]*/
+bool set_protocol_position(Protocol_Session* session, char* arguments)
+{
+	Reversi_Game* game = session->engines[BLACK_INDEX];
+	char* moves = strstr(arguments, " moves");
+	char* cells = session->response;
+	int saved_color_to_move = session->color_to_move;
+	bool position_is_valid = true;
+
+	if (moves != NULL)
 	{
-		current_input_command = malloc(11 * sizeof(char));
+		*moves = '\0';
+		moves += 6;
 	}
+	/*no go is running, so its board keeps the old position in case the new one is refused*/
+	copy_the_board(game, session->search_board, session->board);
+	arguments += strspn(arguments, " ");
+	if (strncmp(arguments, "startpos", 8) == 0)
+	{
+		Board_Cell** initial_board = create_the_board(game);
 
-	printf("\n>");
-	fgets(current_input_command,10,stdin);
-	if(strcmp(current_input_command,"\n") == 0)
+		copy_the_board(game, session->board, initial_board);
+		delete_the_board(game, initial_board);
+		session->color_to_move = BLACK_INDEX;
+	}
+	else
+	{
+		session->color_to_move = parse_position_text(arguments, cells, game->board_size * game->board_size);
+		position_is_valid = session->color_to_move != INVALID_VALUE && load_board_position(game, session->board, cells);
+	}
+	for (char* token = moves != NULL ? strtok(moves, " ") : NULL; token != NULL && position_is_valid; token = strtok(NULL, " "))
 	{
-		fgets(current_input_command,11,stdin);
+		position_is_valid = play_protocol_move(session, token);
 	}
-	current_input_command[strcspn(current_input_command, "\n")] = 0;
 
-	if (strcmp(current_input_command, "quit") == 0)
+	if (!position_is_valid)
 	{
-		return QUIT;
+		copy_the_board(game, session->board, session->search_board);
+		session->color_to_move = saved_color_to_move;
 	}
+	return position_is_valid;
+}
+
+/*stats: the counters of the last go that answered, as name value pairs. A running go is neither waited for nor
+  stopped*/
+void write_protocol_statistics(Protocol_Session* session)
+{
+	Search_Statistics* statistics = &session->statistics;
+
+	lock_mutex(&session->output_lock);
+	snprintf(session->response, PROTOCOL_RESPONSE_LENGTH,
+		"stats nodes %llu depth %d time %lld leaves %llu hash_probes %llu hash_hits %llu hash_cutoffs %llu endgame_solves %llu probcut_cuts %llu\n",
+		statistics->nodes, session->search_depth, session->search_time, statistics->leaf_evaluations, statistics->hash_probes,
+		statistics->hash_hits, statistics->hash_cutoffs, statistics->endgame_solves, statistics->probcut_cuts);
+	fwrite(session->response, 1, strlen(session->response), stdout);
+	fflush(stdout);
+	unlock_mutex(&session->output_lock);
+}
 
-	if (strcmp(current_input_command, "showstate") == 0)
+/*protocol <size> <level> [option=value ...]: reads one command per line and answers each with one line. Nothing
+  else is printed, the board included, so a program can drive the engine*/
+int run_machine_protocol(char* menu_arguments)
+{
+	const char s[2] = " ";
+	char* token;
+	char* command;
+	int board_size = INVALID_VALUE;
+	int line_length;
+	Reversi_Game* settings = create_reversi_game();
+	Protocol_Session session;
+
+	memset(&session, 0, sizeof(session));
+	token = strtok(menu_arguments, s);
+	for (int menu_item = 1; token != NULL; menu_item++)
 	{
-		if (current_turn == COMPUTER_TURN)
+		if (menu_item == 1)
+		{
+			board_size = atoi(token);
+		}
+		else if (menu_item == 2)
 		{
-			display_the_board(board, NULL, false); 
-			update_disks_count(board);
-			printf("%s player (computer) plays now\n", computer_disk_color);
-			printf("White: %d - Black: %d\n", current_white_disks, current_black_disks);
+			settings->game_level = atoi(token);
 		}
 		else
 		{
-			int** allowed_moves_board = create_valid_moves_board();
-			update_valid_moves_board(board, allowed_moves_board, USER_PLAYER);
-			
-			display_the_board(board, allowed_moves_board, true);
-			delete_valid_moves_board(allowed_moves_board);
-
-			update_disks_count(board);
-			printf("%s player (human) plays now\n", user_disk_color);
-			printf("White: %d - Black: %d\n", current_white_disks, current_black_disks);
+			parse_game_option(settings, token);
 		}
+		token = strtok(NULL, s);
 	}
 
-	else if (strcmp(current_input_command, "cont") == 0)
+	if (board_size < MIN_BOARD_SIZE || board_size > MAX_BOARD_SIZE || board_size % 2 != 0 || !is_valid_level(settings->game_level))
 	{
-		current_move = play_computer_move();
-		int** allowed_moves_board = create_valid_moves_board();
-		update_valid_moves_board(board, allowed_moves_board, USER_PLAYER);
+		printf("Invalid protocol: the size must be even and between %d and %d, the level at least 1\n", MIN_BOARD_SIZE, MAX_BOARD_SIZE);
+		delete_reversi_game(settings);
+		return 1;
+	}
 
-		display_the_board(board, allowed_moves_board, true); 
-		delete_valid_moves_board(allowed_moves_board);
+	initialize_zobrist_keys();
+	session.max_level = settings->game_level;
+	session.move_time_limit = settings->move_time_limit != NO_TIME_LIMIT ? settings->move_time_limit : PROTOCOL_UNLIMITED_TIME;
+	session.engines[BLACK_INDEX] = create_self_play_engine(settings, board_size, BLACK_INDEX);
+	session.engines[WHITE_INDEX] = create_self_play_engine(settings, board_size, WHITE_INDEX);
+	session.board = create_the_board(session.engines[BLACK_INDEX]);
+	session.search_board = create_the_board(session.engines[BLACK_INDEX]);
+	session.color_to_move = BLACK_INDEX;
+	create_mutex(&session.output_lock);
+	/*a position line holds every cell; responses are shorter*/
+	line_length = board_size * board_size * (PROTOCOL_MOVE_LENGTH + 1) + MENU_INPUT_LENGTH;
+	command = (char*)malloc(line_length);
+	session.response = (char*)malloc(max(line_length, PROTOCOL_RESPONSE_LENGTH));
+	/*the menu prompt ends the line the protocol answers start on*/
+	write_protocol_response(&session, "\n");
+
+	while (fgets(command, line_length, stdin) != NULL)
+	{
+		char* arguments;
 
-		update_disks_count(board);
+		command[strcspn(command, "\r\n")] = '\0';
+		arguments = command + strcspn(command, " ");
+		if (*arguments != '\0')
+		{
+			*arguments++ = '\0';
+		}
 
-		if (current_move.row_index == INVALID_VALUE && current_move.column_index == INVALID_VALUE)
+		if (strcmp(command, "quit") == 0)
 		{
-			printf("No move possible for computer\n");
+			break;
+		}
+		else if (strcmp(command, "isready") == 0)
+		{
+			write_protocol_response(&session, "readyok\n");
+		}
+		else if (strcmp(command, "go") == 0)
+		{
+			start_protocol_search(&session, arguments);
+		}
+		else if (strcmp(command, "stop") == 0)
+		{
+			stop_protocol_search(&session);
+		}
+		else if (strcmp(command, "position") == 0)
+		{
+			stop_protocol_search(&session);
+			write_protocol_response(&session, set_protocol_position(&session, arguments) ? "ok\n" : "error position\n");
+		}
+		else if (strcmp(command, "move") == 0)
+		{
+			stop_protocol_search(&session);
+			write_protocol_response(&session, play_protocol_move(&session, arguments) ? "ok\n" : "error illegal move\n");
+		}
+		else if (strcmp(command, "stats") == 0)
+		{
+			write_protocol_statistics(&session);
+		}
+		else if (strcmp(command, "show") == 0)
+		{
+			char* cells = session.response + line_length / 2;
 
-			int** allowed_moves_board = create_valid_moves_board();
-			update_valid_moves_board(board, allowed_moves_board, USER_PLAYER);
+			for (int i = 0; i < board_size * board_size; i++)
+			{
+				char disk_color = session.board[i / board_size][i % board_size].cell_disk_color;
+
+				cells[i] = disk_color == ' ' ? '-' : disk_color;
+			}
+			cells[board_size * board_size] = '\0';
+			strcpy(session.response, "position ");
+			format_position_text(cells, session.color_to_move, session.response + 9);
+			strcat(session.response, "\n");
+			write_protocol_response(&session, session.response);
+		}
+		else if (command[0] != '\0')
+		{
+			write_protocol_response(&session, "error unknown command\n");
+		}
+	}
+
+	stop_protocol_search(&session);
+	delete_the_board(session.engines[BLACK_INDEX], session.board);
+	delete_the_board(session.engines[BLACK_INDEX], session.search_board);
+	delete_reversi_game(session.engines[BLACK_INDEX]);
+	delete_reversi_game(session.engines[WHITE_INDEX]);
+	delete_reversi_game(settings);
+	delete_mutex(&session.output_lock);
+	free(command);
+	free(session.response);
+	return 0;
+}
+
+/******************/
+/*LEAF BENCHMARK*/
+/******************/
+
+/*Evaluates every child of the samples, from the computer's point of view, with kernel or, without one, by playing
+  each child and calling evaluate_search_leaf as the search did before leaf batches*/
+void evaluate_benchmark_leaves(Search_Position* samples, int sample_count, const int* squares, const int* first_squares, const Leaf_Batch_Kernel* kernel, int* leaf_values)
+{
+	for (int k = 0; k < sample_count; k++)
+	{
+		Search_Position* position = &samples[k];
+		int child_count = first_squares[k + 1] - first_squares[k];
 
-			if (no_valid_moves_exist(allowed_moves_board))
+		for (int first_index = 0; first_index < child_count; first_index += LEAF_BATCH_WIDTH)
+		{
+			const int* batch_squares = squares + first_squares[k] + first_index;
+			int* batch_values = leaf_values + first_squares[k] + first_index;
+			int count = min(LEAF_BATCH_WIDTH, child_count - first_index);
+
+			if (kernel == NULL)
 			{
-				delete_valid_moves_board(allowed_moves_board);
-				update_disks_count(board);
-				printf("White: %d - Black: %d\n", current_white_disks, current_black_disks);
-				printf("END OF GAME\n");
-				return COMPLETE;
+				for (int i = 0; i < count; i++)
+				{
+					Move_Undo move_undo;
+
+					make_search_move(position, batch_squares[i], &move_undo);
+					batch_values[i] = evaluate_search_leaf(position);
+					unmake_search_move(position, &move_undo);
+				}
+				continue;
 			}
-			delete_valid_moves_board(allowed_moves_board);
+			kernel->evaluate_children(position->bitboard.player_disks, position->bitboard.opponent_disks, batch_squares, count,
+				position->game->evaluation == EVALUATION_MOBILITY, batch_values);
+			if (position->player_to_move != COMPUTER_PLAYER)
+			{
+				for (int i = 0; i < count; i++)
+				{
+					batch_values[i] = -batch_values[i];
+				}
+			}
+		}
+	}
+}
+
+/*leafbench <positions> [option=value ...]: the cost per horizon leaf of 8x8 positions from random games, evaluated
+  one by one as the search did before and in batches by each kernel the processor runs, and a check that all of
+  them give the same values. The eval and simd options apply; seed=<n> and rounds=<n> set the positions and the
+  passes timed over them*/
+int run_leaf_benchmark(char* menu_arguments)
+{
+	const char s[2] = " ";
+	char* token;
+	int sample_count = INVALID_VALUE;
+	int round_count = LEAF_BENCHMARK_ROUNDS;
+	uint64_t random_state = ZOBRIST_SEED;
+	Reversi_Game* game = create_reversi_game();
+	Search_Workspace* workspace;
+	Search_Position* samples;
+	int* squares;
+	int* first_squares;
+	int* reference_values;
+	int* leaf_values;
+	const Leaf_Batch_Kernel* kernels[2];
+	int kernel_count = ZERO;
+	int leaf_count = ZERO;
+	int exit_code = 0;
+
+	/*the computer plays black, so the player to move also tells the color*/
+	strcpy(game->computer_disk_color, "Black");
+	strcpy(game->user_disk_color, "White");
+	game->board_size = BITBOARD_SIZE;
+	game->transposition_table_megabytes = ZERO;
+
+	token = strtok(menu_arguments, s);
+	for (int menu_item = 1; token != NULL; menu_item++)
+	{
+		if (menu_item == 1)
+		{
+			sample_count = atoi(token);
+		}
+		else if (strncmp(token, "seed=", 5) == 0)
+		{
+			random_state = strtoull(token + 5, NULL, 10);
+		}
+		else if (strncmp(token, "rounds=", 7) == 0)
+		{
+			round_count = max(atoi(token + 7), 1);
 		}
 		else
 		{
-			printf("Move played: %c%d\n", current_move.board_column, current_move.board_row);
+			parse_game_option(game, token);
 		}
-		printf("%s player (human) plays now\n", user_disk_color);
-		printf("White: %d - Black: %d\n", current_white_disks, current_black_disks);
-		switch_the_turn();
+		token = strtok(NULL, s);
 	}
-	else //play <move>
+
+	if (sample_count < 1 || game->evaluation == EVALUATION_PATTERNS)
 	{
-		const char s[2] = " ";
-		char* token;
+		printf("Invalid leafbench: give at least one position, and eval=disks or eval=mobility\n");
+		delete_reversi_game(game);
+		return 1;
+	}
 
-		token = strtok(current_input_command, s);
-		token = strtok(NULL, s);
+	/*the sample games are played on the search position, whose flip stack holds one move per level*/
+	game->game_level = BITBOARD_SIZE * BITBOARD_SIZE;
+	game->leaf_batching_enabled = true;
+	initialize_zobrist_keys();
+	start_reversi_game(game);
+	workspace = &game->search_threads[MAIN_SEARCH_THREAD].workspace;
+
+	samples = (Search_Position*)malloc(sample_count * sizeof(Search_Position));
+	squares = (int*)malloc(sample_count * BITBOARD_SIZE * BITBOARD_SIZE * sizeof(int));
+	first_squares = (int*)malloc((sample_count + 1) * sizeof(int));
+	for (int k = 0; k < sample_count; k++)
+	{
+		int plies = (int)(get_next_random_key(&random_state) % (BITBOARD_SIZE * BITBOARD_SIZE - 4));
+		Move_List valid_moves;
+
+		/*the random games start over at the initial position and are never taken back*/
+		workspace->flip_stack_top = ZERO;
+		samples[k] = create_search_position(game, game->board, COMPUTER_PLAYER, workspace);
+		for (int ply = 0; ply < plies; ply++)
+		{
+			Move_Undo move_undo;
 
-		current_move.board_column = token[0];
-		current_move.board_row = token[1] - '0';
+			valid_moves = get_search_moves(&samples[k]);
+			if (no_valid_moves_exist(&valid_moves))
+			{
+				release_valid_moves(workspace, &valid_moves);
+				if (!opponent_has_moves(&samples[k]))
+				{
+					break;
+				}
+				pass_search_position(&samples[k]);
+				continue;
+			}
+			make_search_move(&samples[k], valid_moves.moves[get_next_random_key(&random_state) % valid_moves.count], &move_undo);
+			release_valid_moves(workspace, &valid_moves);
+		}
+		/*a position without moves is sampled again*/
+		valid_moves = get_search_moves(&samples[k]);
+		first_squares[k] = leaf_count;
+		memcpy(squares + leaf_count, valid_moves.moves, valid_moves.count * sizeof(int));
+		leaf_count += valid_moves.count;
+		if (no_valid_moves_exist(&valid_moves))
+		{
+			k--;
+		}
+		release_valid_moves(workspace, &valid_moves);
+	}
+	first_squares[sample_count] = leaf_count;
+	workspace->flip_stack_top = ZERO;
 
-		current_move.column_index = tolower(token[0]) - 'a';
-		current_move.row_index = token[1] - '1';
+	kernels[kernel_count++] = &leaf_scalar_kernel;
+	if (game->leaf_kernel != NULL && game->leaf_kernel != &leaf_scalar_kernel)
+	{
+		kernels[kernel_count++] = game->leaf_kernel;
+	}
+	reference_values = (int*)malloc(leaf_count * sizeof(int));
+	leaf_values = (int*)malloc(leaf_count * sizeof(int));
 
-		//check validity of the move
-		int** allowed_moves_board = create_valid_moves_board();
-		update_valid_moves_board(board, allowed_moves_board, USER_PLAYER);
-		if (!is_move_allowed(allowed_moves_board, current_move))
+	printf("Leaf evaluation 8x8, eval %s: %d positions, %d leaves, %d rounds\n", get_evaluation_name(game->evaluation), sample_count, leaf_count, round_count);
+	for (int j = -1; j < kernel_count; j++)
+	{
+		const Leaf_Batch_Kernel* kernel = j < 0 ? NULL : kernels[j];
+		int* values = j < 0 ? reference_values : leaf_values;
+		long long start_time = get_time_in_milliseconds();
+		long long elapsed_time;
+
+		for (int round = 0; round < round_count; round++)
 		{
-			//invalid input, retry
-			printf("Invalid input\n");
-			delete_valid_moves_board(allowed_moves_board);
-			return CONTINUE;
+			evaluate_benchmark_leaves(samples, sample_count, squares, first_squares, kernel, values);
+		}
+		elapsed_time = get_time_in_milliseconds() - start_time;
+		printf("%s%s: %.1f ns/leaf\n", kernel == NULL ? "one by one" : kernel->name, kernel == NULL ? "" : " batches",
+			elapsed_time * 1000000.0 / ((double)leaf_count * round_count));
+
+		if (kernel != NULL && memcmp(values, reference_values, leaf_count * sizeof(int)) != 0)
+		{
+			printf("The %s batches give other values than one by one\n", kernel->name);
+			exit_code = 1;
 		}
-		delete_valid_moves_board(allowed_moves_board);
-		register_move(board, current_move, USER_PLAYER);
-		
-		display_the_board(board, NULL, false);
-		update_disks_count(board);
-		printf("Move played: %c%d\n", current_move.board_column, current_move.board_row);
-		printf("%s player (computer) plays now\n", computer_disk_color);
-		printf("White: %d - Black: %d\n", current_white_disks, current_black_disks);
-		switch_the_turn();
 	}
-	return CONTINUE;
+
+	free(leaf_values);
+	free(reference_values);
+	free(first_squares);
+	free(squares);
+	free(samples);
+	delete_reversi_game(game);
+	return exit_code;
 }
 
+/******************/
+/*MENU MODES*/
+/******************/
+
+/*Modes that take the place of an interactive game, by the first word of the menu input*/
+typedef struct
+{
+	const char* prefix;
+	int (*run)(char* menu_arguments);
+}Menu_Mode;
+
+static const Menu_Mode menu_modes[] =
+{
+	{ "selfplay", run_self_play },
+	{ "perft", run_perft },
+	{ "book", run_book_builder },
+	{ "probcut", run_probcut_calibration },
+	{ "batch", run_batch_analysis },
+	{ "replay", run_record_replay },
+	{ "protocol", run_machine_protocol },
+	{ "leafbench", run_leaf_benchmark },
+};
+
 int main()
 {
 	char* menu_selection = NULL;
@@ -878,14 +7689,30 @@ int main()
 	char* token;
 	int menu_item = 0;
 	Game_Status result = CONTINUE;
+	Reversi_Game* game = create_reversi_game();
 	
 
 	if (menu_selection == NULL)
 	{
-		menu_selection = malloc(18 * sizeof(char));
+		menu_selection = malloc(MENU_INPUT_LENGTH * sizeof(char));
 	}
 	printf(">");
-	fgets(menu_selection,18,stdin);
+	fgets(menu_selection,MENU_INPUT_LENGTH,stdin);
+	menu_selection[strcspn(menu_selection, "\r\n")] = 0;
+
+	for (int i = 0; i < (int)(sizeof(menu_modes) / sizeof(menu_modes[0])); i++)
+	{
+		int prefix_length = (int)strlen(menu_modes[i].prefix);
+
+		if (strncmp(menu_selection, menu_modes[i].prefix, prefix_length) == 0)
+		{
+			int exit_code = menu_modes[i].run(menu_selection + prefix_length);
+
+			delete_reversi_game(game);
+			free(menu_selection);
+			return exit_code;
+		}
+	}
 
 	/* get the first token */
 	token = strtok(menu_selection, s);
@@ -901,37 +7728,49 @@ int main()
 		{
 			if (strcmp(token, "white") == 0)
 			{
-				strncpy(user_disk_color,"White",5);
-				strncpy(computer_disk_color, "Black",5);
-				current_turn = COMPUTER_TURN;
+				strncpy(game->user_disk_color,"White",5);
+				strncpy(game->computer_disk_color, "Black",5);
+				game->current_turn = COMPUTER_TURN;
 			}
 			else
 			{
-				strncpy(user_disk_color, "Black",5);
-				strncpy(computer_disk_color, "White",5);
-				current_turn = USER_TURN;
+				strncpy(game->user_disk_color, "Black",5);
+				strncpy(game->computer_disk_color, "White",5);
+				game->current_turn = USER_TURN;
 			}
 		}
 		else if (menu_item == 2)
 		{
 			//check for valid and even number
-			board_size = atoi(token);
+			game->board_size = atoi(token);
 		}
 		else if (menu_item == 3)
 		{
-			game_level = atoi(token);
+			game->game_level = atoi(token);
+		}
+		else if (token != NULL)
+		{
+			parse_game_option(game, token);
 		}
 	}
 
-	//reset_parameters();
-	board = create_the_board();
+	if (game->board_size < MIN_BOARD_SIZE || game->board_size > MAX_BOARD_SIZE || game->board_size % 2 != 0 || game->game_level < 1)
+	{
+		printf("Invalid game: the size must be even and between %d and %d, the level at least 1\n", MIN_BOARD_SIZE, MAX_BOARD_SIZE);
+		delete_reversi_game(game);
+		free(menu_selection);
+		return 1;
+	}
+
+	initialize_zobrist_keys();
+	start_reversi_game(game);
 
 	while (result == CONTINUE)
 	{
-		result = play_game();
+		result = play_game(game);
 	}
 
-	reset_parameters();
+	delete_reversi_game(game);
 	free(menu_selection);
 	
 	return 0;